@@ -0,0 +1,275 @@
+#include <stdlib.h>
+#include <string.h>
+#include "chain.h"
+
+// Bytes que se tocan de una vez al reservar un buffer
+#define CHAIN_PAGE 4096
+
+// C (M x N) = A (M x K) * B (K x N), todas por filas y contiguas, por
+// bloques de mc filas
+static void product(const int32_t *A, const int32_t *B, int32_t *C, int M,
+                    int N, int K, const TileConfig *tiles) {
+  int bloques = gemm_num_blocks(M, tiles->mc);
+
+  #pragma omp parallel for schedule(dynamic) if(bloques > 1)
+  for (int b = 0; b < bloques; b++) {
+    int i0 = b * tiles->mc;
+    int mb = (i0 + tiles->mc < M) ? tiles->mc : M - i0;
+    hpc_gemm_i32_tiles(GEMM_NO_TRANS, GEMM_NO_TRANS, mb, N, K, 1,
+                       A + (size_t)i0 * K, K, B, N, 0, C + (size_t)i0 * N, N,
+                       tiles);
+  }
+}
+
+void chain_workspace_init(ChainWorkspace *ws) {
+  memset(ws, 0, sizeof(*ws));
+}
+
+void chain_workspace_free(ChainWorkspace *ws) {
+  for (int i = 0; i < ws->count; i++) {
+    free(ws->buf[i]);
+  }
+  chain_workspace_init(ws);
+}
+
+// Asegurar que los buffers tienen al menos elems elementos. Si hay que
+// agrandarlos se liberan todos (ninguno está en uso entre llamadas) y se
+// vuelven a reservar según se pidan
+static void ws_reserve(ChainWorkspace *ws, size_t elems) {
+  if (elems <= ws->capacity) {
+    return;
+  }
+  int allocations = ws->allocations;
+  chain_workspace_free(ws);
+  ws->allocations = allocations;
+  ws->capacity = elems;
+}
+
+// Un buffer libre, reservando uno más si no lo hay. Los nuevos se tocan
+// enteros (en paralelo) para que sus fallos de página no caigan dentro de
+// un producto
+static int32_t *ws_take(ChainWorkspace *ws) {
+  for (int i = 0; i < ws->count; i++) {
+    if (!ws->busy[i]) {
+      ws->busy[i] = 1;
+      return ws->buf[i];
+    }
+  }
+  if (ws->count == CHAIN_MAX_BUFFERS) {
+    return NULL;
+  }
+
+  size_t bytes = (ws->capacity * sizeof(int32_t) + 63) / 64 * 64;
+  char *buf = aligned_alloc(64, bytes);
+  if (!buf) {
+    return NULL;
+  }
+  long pages = (long)((bytes + CHAIN_PAGE - 1) / CHAIN_PAGE);
+  #pragma omp parallel for schedule(static)
+  for (long p = 0; p < pages; p++) {
+    size_t off = (size_t)p * CHAIN_PAGE;
+    size_t len = (off + CHAIN_PAGE < bytes) ? CHAIN_PAGE : bytes - off;
+    memset(buf + off, 0, len);
+  }
+
+  ws->buf[ws->count] = (int32_t *)buf;
+  ws->busy[ws->count] = 1;
+  ws->count++;
+  ws->allocations++;
+  return (int32_t *)buf;
+}
+
+// Devolver un buffer; no hace nada si p no es del espacio de trabajo
+static void ws_release(ChainWorkspace *ws, const int32_t *p) {
+  for (int i = 0; i < ws->count; i++) {
+    if (ws->buf[i] == p) {
+      ws->busy[i] = 0;
+    }
+  }
+}
+
+// El buffer de bufs que no es ni x ni y
+static int32_t *other(int32_t *bufs[3], const int32_t *x, const int32_t *y) {
+  for (int i = 0; i < 3; i++) {
+    if (bufs[i] != x && bufs[i] != y) {
+      return bufs[i];
+    }
+  }
+  return NULL;
+}
+
+int chain_power_products(unsigned k) {
+  int squares = 0, bits = 0;
+  for (; k != 0; k >>= 1) {
+    bits += k & 1;
+    squares += (k > 1);
+  }
+  return (bits > 0) ? squares + bits - 1 : 0;
+}
+
+int chain_power(const int32_t *A, int n, unsigned k, int32_t *C,
+                ChainWorkspace *ws, const TileConfig *tiles,
+                ChainCheck check, void *check_arg) {
+  size_t nn = (size_t)n * n;
+
+  if (k == 0) {
+    memset(C, 0, nn * sizeof(int32_t));
+    for (int i = 0; i < n; i++) {
+      C[(size_t)i * n + i] = 1;
+    }
+    return 1;
+  }
+
+  ws_reserve(ws, nn);
+  int32_t *sq = ws_take(ws);
+  int32_t *tmp = ws_take(ws);
+  if (!sq || !tmp) {
+    ws_release(ws, sq);
+    ws_release(ws, tmp);
+    return 0;
+  }
+
+  // p = A^(2^i) y acc = producto de las potencias de los bits ya vistos
+  // (NULL mientras es la identidad). Cada producto escribe en el buffer que
+  // no usan ni p ni acc, empezando por C; la primera potencia de acc es p
+  // sin copiarla
+  int32_t *bufs[3] = { C, sq, tmp };
+  const int32_t *p = A;
+  const int32_t *acc = NULL;
+  while (1) {
+    if (k & 1) {
+      if (acc == NULL) {
+        acc = p;
+      } else {
+        int32_t *out = other(bufs, acc, p);
+        product(acc, p, out, n, n, n, tiles);
+        if (check) {
+          check(acc, p, out, n, check_arg);
+        }
+        acc = out;
+      }
+    }
+    k >>= 1;
+    if (k == 0) {
+      break;
+    }
+    int32_t *out = other(bufs, acc, p);
+    product(p, p, out, n, n, n, tiles);
+    if (check) {
+      check(p, p, out, n, check_arg);
+    }
+    p = out;
+  }
+
+  if (acc != C) {
+    memcpy(C, acc, nn * sizeof(int32_t));
+  }
+  ws_release(ws, sq);
+  ws_release(ws, tmp);
+  return 1;
+}
+
+int64_t chain_order(const int *dims, int m, int *split) {
+  int64_t *cost = malloc((size_t)m * m * sizeof(int64_t));
+  if (!cost) {
+    return -1;
+  }
+
+  for (int i = 0; i < m; i++) {
+    cost[(size_t)i * m + i] = 0;
+    split[(size_t)i * m + i] = i;
+  }
+  for (int len = 2; len <= m; len++) {
+    for (int i = 0; i + len - 1 < m; i++) {
+      int j = i + len - 1;
+      int64_t best = -1;
+      for (int k = i; k < j; k++) {
+        int64_t c = cost[(size_t)i * m + k] + cost[(size_t)(k + 1) * m + j] +
+                    (int64_t)dims[i] * dims[k + 1] * dims[j + 1];
+        if (best < 0 || c < best) {
+          best = c;
+          split[(size_t)i * m + j] = k;
+        }
+      }
+      cost[(size_t)i * m + j] = best;
+    }
+  }
+
+  int64_t total = cost[m - 1];
+  free(cost);
+  return total;
+}
+
+int64_t chain_cost_left(const int *dims, int m) {
+  int64_t total = 0;
+  for (int k = 1; k < m; k++) {
+    total += (int64_t)dims[0] * dims[k] * dims[k + 1];
+  }
+  return total;
+}
+
+typedef struct {
+  const int32_t *const *mats;
+  const int *dims;
+  int m;
+  const int *split;
+  ChainWorkspace *ws;
+  const TileConfig *tiles;
+} ChainPlan;
+
+// Elementos del mayor resultado intermedio (sin contar el final, que va a C)
+static size_t plan_capacity(const ChainPlan *c, int i, int j, int root) {
+  if (i == j) {
+    return 0;
+  }
+  int k = c->split[(size_t)i * c->m + j];
+  size_t own = root ? 0 : (size_t)c->dims[i] * c->dims[j + 1];
+  size_t left = plan_capacity(c, i, k, 0);
+  size_t right = plan_capacity(c, k + 1, j, 0);
+  if (left > own) {
+    own = left;
+  }
+  return (right > own) ? right : own;
+}
+
+// Producto de A_i .. A_j en dst (o en un buffer del espacio de trabajo si
+// dst es NULL). Devuelve el resultado, o NULL si faltan buffers
+static const int32_t *plan_eval(const ChainPlan *c, int i, int j,
+                                int32_t *dst) {
+  if (i == j) {
+    return c->mats[i];
+  }
+
+  // Primero el lado con más productos: su resultado ocupa un buffer
+  // mientras se calcula el otro, que necesita menos
+  int k = c->split[(size_t)i * c->m + j];
+  const int32_t *L, *R;
+  if (k - i >= j - k - 1) {
+    L = plan_eval(c, i, k, NULL);
+    R = L ? plan_eval(c, k + 1, j, NULL) : NULL;
+  } else {
+    R = plan_eval(c, k + 1, j, NULL);
+    L = R ? plan_eval(c, i, k, NULL) : NULL;
+  }
+  int32_t *out = (L && R) ? (dst ? dst : ws_take(c->ws)) : NULL;
+
+  if (out) {
+    product(L, R, out, c->dims[i], c->dims[j + 1], c->dims[k + 1], c->tiles);
+  }
+  ws_release(c->ws, L);
+  ws_release(c->ws, R);
+  return out;
+}
+
+int chain_product(const int32_t *const *mats, const int *dims, int m,
+                  const int *split, int32_t *C, ChainWorkspace *ws,
+                  const TileConfig *tiles) {
+  if (m == 1) {
+    memcpy(C, mats[0], (size_t)dims[0] * dims[1] * sizeof(int32_t));
+    return 1;
+  }
+
+  ChainPlan plan = { mats, dims, m, split, ws, tiles };
+  ws_reserve(ws, plan_capacity(&plan, 0, m - 1, 1));
+  return plan_eval(&plan, 0, m - 1, C) != NULL;
+}
@@ -0,0 +1,61 @@
+#ifndef CHAIN_H
+#define CHAIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "gemm.h"
+
+// Potencias (A^k) y cadenas de productos (A1 * A2 * ... * Am) con matrices
+// por filas. Los resultados intermedios van a un juego de buffers alineados
+// que se reservan (y se tocan) la primera vez y se reutilizan entre
+// productos y entre llamadas: en series largas de productos dependientes,
+// como el conteo de caminos con matrices de adyacencia, no se paga una
+// reserva y sus fallos de página por producto. Compilado con OpenMP cada
+// producto reparte bloques de filas entre los hilos
+
+#define CHAIN_MAX_BUFFERS 32
+
+typedef struct {
+  int32_t *buf[CHAIN_MAX_BUFFERS];
+  int busy[CHAIN_MAX_BUFFERS];
+  int count;          // buffers reservados
+  size_t capacity;    // elementos de cada buffer
+  int allocations;    // reservas hechas desde chain_workspace_init
+} ChainWorkspace;
+
+void chain_workspace_init(ChainWorkspace *ws);
+void chain_workspace_free(ChainWorkspace *ws);
+
+// Llamada opcional tras cada producto Z = X * Y (n x n) de chain_power,
+// con X, Y y Z todavía intactas (para comprobarlo paso a paso)
+typedef void (*ChainCheck)(const int32_t *X, const int32_t *Y,
+                           const int32_t *Z, int n, void *arg);
+
+// C = A^k (n x n; A^0 es la identidad) por cuadrados sucesivos: unos
+// log2(k) cuadrados y un producto por cada bit a 1 de k. C no puede ser A.
+// Si check no es NULL se llama con cada producto. Devuelve 0 si falta
+// memoria
+int chain_power(const int32_t *A, int n, unsigned k, int32_t *C,
+                ChainWorkspace *ws, const TileConfig *tiles,
+                ChainCheck check, void *check_arg);
+
+// Productos de matriz que hace chain_power con el exponente k
+int chain_power_products(unsigned k);
+
+// Orden óptimo (programación dinámica, O(m^3)) de la cadena de m matrices,
+// la i de dims[i] x dims[i + 1]: split[i * m + j] es el k con el que el
+// producto de A_i .. A_j se hace como (A_i .. A_k)(A_k+1 .. A_j). Devuelve
+// las multiplicaciones-suma de ese orden, o -1 si falta memoria
+int64_t chain_order(const int *dims, int m, int *split);
+
+// Multiplicaciones-suma de la cadena de izquierda a derecha
+int64_t chain_cost_left(const int *dims, int m);
+
+// C = mats[0] * ... * mats[m - 1] en el orden de split (de chain_order).
+// C es dims[0] x dims[m] y no puede ser ninguna de las de entrada.
+// Devuelve 0 si falta memoria
+int chain_product(const int32_t *const *mats, const int *dims, int m,
+                  const int *split, int32_t *C, ChainWorkspace *ws,
+                  const TileConfig *tiles);
+
+#endif
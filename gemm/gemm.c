@@ -0,0 +1,546 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "gemm.h"
+#include "microkernel.h"
+
+#define DEFAULT_MC 64
+#define DEFAULT_NC 512
+#define DEFAULT_KC 256
+
+static int min_int(int a, int b) {
+  return a < b ? a : b;
+}
+
+// Paneles empaquetados de cada hilo, reutilizados entre llamadas (solo
+// crecen): una serie de productos seguidos no paga una reserva y sus fallos
+// de página en cada uno. Un hilo no vuelve a entrar en el kernel antes de
+// salir (dentro no hay puntos de planificación de tareas), así que nunca
+// hay dos usos a la vez. Al reservar por primera vez se registran en una
+// clave pthread cuyo destructor los libera cuando termina el hilo
+typedef struct {
+  int32_t *data;
+  size_t size;
+} PackBuffer;
+
+typedef struct {
+  PackBuffer a, b;
+  int registered;
+} PackCache;
+
+static _Thread_local PackCache pack_cache;
+static pthread_key_t pack_key;
+static pthread_once_t pack_once = PTHREAD_ONCE_INIT;
+static int pack_key_ok = 0;
+
+static void pack_cache_free(void *arg) {
+  PackCache *c = (PackCache *)arg;
+  free(c->a.data);
+  free(c->b.data);
+  memset(c, 0, sizeof(*c));
+}
+
+static void pack_key_create(void) {
+  pack_key_ok = pthread_key_create(&pack_key, pack_cache_free) == 0;
+}
+
+static int32_t *pack_buffer(PackBuffer *p, size_t size) {
+  if (p->size < size) {
+    if (!pack_cache.registered) {
+      pthread_once(&pack_once, pack_key_create);
+      pack_cache.registered =
+          pack_key_ok && pthread_setspecific(pack_key, &pack_cache) == 0;
+    }
+    free(p->data);
+    p->data = aligned_alloc(64, (size + 63) / 64 * 64);
+    p->size = p->data ? size : 0;
+  }
+  return p->data;
+}
+
+// Leer un tamaño de bloque de una variable de entorno
+static int env_block(const char *name, int fallback) {
+  const char *value = getenv(name);
+  if (value == NULL) {
+    return fallback;
+  }
+  int block = atoi(value);
+  return block > 0 ? block : fallback;
+}
+
+const char *gemm_order_name(GemmLoopOrder order) {
+  switch (order) {
+    case GEMM_ORDER_IKJ: return "ikj";
+    default: return "jki";
+  }
+}
+
+int gemm_order_parse(const char *name, GemmLoopOrder *order) {
+  if (strcmp(name, "jki") == 0) {
+    *order = GEMM_ORDER_JKI;
+  } else if (strcmp(name, "ikj") == 0) {
+    *order = GEMM_ORDER_IKJ;
+  } else {
+    return 0;
+  }
+  return 1;
+}
+
+// Valores sin variables de entorno: los de compilación o los del perfil
+static TileConfig base_tiles = { DEFAULT_MC, DEFAULT_NC, DEFAULT_KC,
+                                 GEMM_ORDER_JKI };
+
+void gemm_tiles_init(TileConfig *tiles) {
+  tiles->mc = env_block("GEMM_MC", base_tiles.mc);
+  tiles->nc = env_block("GEMM_NC", base_tiles.nc);
+  tiles->kc = env_block("GEMM_KC", base_tiles.kc);
+  tiles->order = base_tiles.order;
+
+  // Se avisa una sola vez aunque cada programa lea los bloques varias
+  static int warned = 0;
+  const char *value = getenv("GEMM_ORDER");
+  if (value != NULL && !gemm_order_parse(value, &tiles->order) && !warned) {
+    warned = 1;
+    fprintf(stderr, "GEMM_ORDER=%s desconocido, se usa %s\n", value,
+            gemm_order_name(tiles->order));
+  }
+}
+
+// Bloques de hpc_gemm_i32, leídos una sola vez antes de main()
+static TileConfig default_tiles = { DEFAULT_MC, DEFAULT_NC, DEFAULT_KC,
+                                    GEMM_ORDER_JKI };
+
+__attribute__((constructor))
+static void init_default_tiles(void) {
+  gemm_tiles_init(&default_tiles);
+}
+
+void gemm_tiles_set_base(const TileConfig *tiles) {
+  base_tiles = *tiles;
+  gemm_tiles_init(&default_tiles);
+}
+
+// Orden i-k-j: el bucle interno recorre filas contiguas de B y C
+static void tile_normal(const int32_t *A, int lda, const int32_t *B, int ldb,
+                        int32_t *C, int ldc, int i0, int i1, int j0, int j1,
+                        int k0, int k1) {
+  for (int i = i0; i < i1; i++) {
+    const int32_t *a = A + (size_t)i * lda;
+    int32_t *c = C + (size_t)i * ldc;
+    for (int k = k0; k < k1; k++) {
+      int32_t aik = a[k];
+      const int32_t *b = B + (size_t)k * ldb;
+      for (int j = j0; j < j1; j++) {
+        c[j] += aik * b[j];
+      }
+    }
+  }
+}
+
+// Con B transpuesta cada elemento es un producto punto contiguo
+static void tile_transposed(const int32_t *A, int lda, const int32_t *B,
+                            int ldb, int32_t *C, int ldc, int i0, int i1,
+                            int j0, int j1, int k0, int k1) {
+  for (int i = i0; i < i1; i++) {
+    const int32_t *a = A + (size_t)i * lda;
+    int32_t *c = C + (size_t)i * ldc;
+    for (int j = j0; j < j1; j++) {
+      const int32_t *b = B + (size_t)j * ldb;
+      int32_t sum = 0;
+      for (int k = k0; k < k1; k++) {
+        sum += a[k] * b[k];
+      }
+      c[j] += sum;
+    }
+  }
+}
+
+static void tile_ref(const int32_t *A, int lda, const int32_t *B, int ldb,
+                     GemmLayout layout, int32_t *C, int ldc, int i0, int i1,
+                     int j0, int j1, int k0, int k1) {
+  if (layout == GEMM_B_TRANSPOSED) {
+    tile_transposed(A, lda, B, ldb, C, ldc, i0, i1, j0, j1, k0, k1);
+  } else {
+    tile_normal(A, lda, B, ldb, C, ldc, i0, i1, j0, j1, k0, k1);
+  }
+}
+
+void gemm_tile(const int32_t *A, const int32_t *B, int32_t *C, int n,
+               GemmLayout layout, int i0, int i1, int j0, int j1,
+               int k0, int k1) {
+  tile_ref(A, n, B, n, layout, C, n, i0, i1, j0, j1, k0, k1);
+}
+
+// Empaquetar alpha * op(A)[i0:i0+mb, k0:k0+kb] en paneles de mr filas
+// (a[k * mr + i]), rellenando con ceros la ultima fila de paneles. Con
+// GEMM_TRANS op(A)[i][k] es A[k * lda + i]
+static void pack_a(const int32_t *A, int lda, GemmTrans trans, int32_t alpha,
+                   int i0, int mb, int k0, int kb, int mr, int32_t *buf) {
+  for (int p = 0; p < mb; p += mr) {
+    int filas = min_int(mr, mb - p);
+    for (int k = 0; k < kb; k++) {
+      for (int i = 0; i < filas; i++) {
+        int32_t v = (trans == GEMM_TRANS)
+                        ? A[(size_t)(k0 + k) * lda + i0 + p + i]
+                        : A[(size_t)(i0 + p + i) * lda + k0 + k];
+        buf[k * mr + i] = alpha * v;
+      }
+      for (int i = filas; i < mr; i++) {
+        buf[k * mr + i] = 0;
+      }
+    }
+    buf += (size_t)kb * mr;
+  }
+}
+
+// Empaquetar B[k0:k0+kb, j0:j0+nb] en paneles de nr columnas (b[k * nr + j])
+static void pack_b(const int32_t *B, int ldb, GemmLayout layout, int k0, int kb,
+                   int j0, int nb, int nr, int32_t *buf) {
+  for (int p = 0; p < nb; p += nr) {
+    int cols = min_int(nr, nb - p);
+    for (int k = 0; k < kb; k++) {
+      for (int j = 0; j < cols; j++) {
+        buf[k * nr + j] = (layout == GEMM_B_TRANSPOSED)
+                              ? B[(size_t)(j0 + p + j) * ldb + k0 + k]
+                              : B[(size_t)(k0 + k) * ldb + j0 + p + j];
+      }
+      for (int j = cols; j < nr; j++) {
+        buf[k * nr + j] = 0;
+      }
+    }
+    buf += (size_t)kb * nr;
+  }
+}
+
+// Recorrer los paneles empaquetados llamando al micro-kernel; los bordes
+// se calculan en un bloque temporal y se suman a la parte valida de C
+static void macro_kernel(const MicroKernel *mk, MicroKernelFn kernel,
+                         const int32_t *a_pack, const int32_t *b_pack,
+                         int32_t *C, int ldc, int i0, int mb, int j0, int nb,
+                         int kb) {
+  int32_t borde[mk->mr * mk->nr] __attribute__((aligned(64)));
+
+  for (int jr = 0; jr < nb; jr += mk->nr) {
+    int cols = min_int(mk->nr, nb - jr);
+    const int32_t *b = b_pack + (size_t)(jr / mk->nr) * kb * mk->nr;
+    for (int ir = 0; ir < mb; ir += mk->mr) {
+      int filas = min_int(mk->mr, mb - ir);
+      const int32_t *a = a_pack + (size_t)(ir / mk->mr) * kb * mk->mr;
+      int32_t *c = C + (size_t)(i0 + ir) * ldc + j0 + jr;
+
+      if (filas == mk->mr && cols == mk->nr) {
+        kernel(kb, a, b, c, ldc);
+      } else {
+        memset(borde, 0, sizeof(borde));
+        kernel(kb, a, b, borde, mk->nr);
+        for (int i = 0; i < filas; i++) {
+          for (int j = 0; j < cols; j++) {
+            c[(size_t)i * ldc + j] += borde[i * mk->nr + j];
+          }
+        }
+      }
+    }
+  }
+}
+
+static int round_up(int x, int m) {
+  return (x + m - 1) / m * m;
+}
+
+// C = beta * C, sin leer C si beta es 0
+static void scale_c(int M, int N, int32_t beta, int32_t *C, int ldc) {
+  if (beta == 1) {
+    return;
+  }
+  for (int i = 0; i < M; i++) {
+    int32_t *c = C + (size_t)i * ldc;
+    if (beta == 0) {
+      memset(c, 0, (size_t)N * sizeof(int32_t));
+    } else {
+      for (int j = 0; j < N; j++) {
+        c[j] *= beta;
+      }
+    }
+  }
+}
+
+void hpc_gemm_i32_tiles(GemmTrans transA, GemmTrans transB, int M, int N,
+                        int K, int32_t alpha, const int32_t *A, int lda,
+                        const int32_t *B, int ldb, int32_t beta, int32_t *C,
+                        int ldc, const TileConfig *tiles) {
+  scale_c(M, N, beta, C, ldc);
+  if (alpha == 0 || K == 0) {
+    return;
+  }
+
+  GemmLayout layout = (transB == GEMM_TRANS) ? GEMM_B_TRANSPOSED
+                                             : GEMM_B_NORMAL;
+  const MicroKernel *mk = gemm_microkernel();
+  size_t a_size = (size_t)round_up(tiles->mc, mk->mr) * tiles->kc * sizeof(int32_t);
+  size_t b_size = (size_t)round_up(tiles->nc, mk->nr) * tiles->kc * sizeof(int32_t);
+  int32_t *a_pack = pack_buffer(&pack_cache.a, a_size);
+  int32_t *b_pack = pack_buffer(&pack_cache.b, b_size);
+
+  if (!a_pack || !b_pack) {
+    // Sin memoria para empaquetar: recorrer A y B directamente
+    for (int i = 0; i < M; i++) {
+      for (int j = 0; j < N; j++) {
+        int32_t sum = 0;
+        for (int k = 0; k < K; k++) {
+          int32_t a = (transA == GEMM_TRANS) ? A[(size_t)k * lda + i]
+                                             : A[(size_t)i * lda + k];
+          int32_t b = (transB == GEMM_TRANS) ? B[(size_t)j * ldb + k]
+                                             : B[(size_t)k * ldb + j];
+          sum += a * b;
+        }
+        C[(size_t)i * ldc + j] += alpha * sum;
+      }
+    }
+    return;
+  }
+
+  if (tiles->order == GEMM_ORDER_IKJ) {
+    // ic -> kc -> jc: el panel mc x kc de A se empaqueta una vez y se
+    // reutiliza para todas las columnas
+    for (int ic = 0; ic < M; ic += tiles->mc) {
+      int mb = min_int(tiles->mc, M - ic);
+      for (int kc = 0; kc < K; kc += tiles->kc) {
+        int kb = min_int(tiles->kc, K - kc);
+        pack_a(A, lda, transA, alpha, ic, mb, kc, kb, mk->mr, a_pack);
+        for (int jc = 0; jc < N; jc += tiles->nc) {
+          int nb = min_int(tiles->nc, N - jc);
+          pack_b(B, ldb, layout, kc, kb, jc, nb, mk->nr, b_pack);
+          macro_kernel(mk, mk->kernel, a_pack, b_pack, C, ldc, ic, mb, jc,
+                       nb, kb);
+        }
+      }
+    }
+  } else {
+    // jc -> kc -> ic: el panel kc x nc de B se empaqueta una vez y se
+    // reutiliza para todas las filas
+    for (int jc = 0; jc < N; jc += tiles->nc) {
+      int nb = min_int(tiles->nc, N - jc);
+      for (int kc = 0; kc < K; kc += tiles->kc) {
+        int kb = min_int(tiles->kc, K - kc);
+        pack_b(B, ldb, layout, kc, kb, jc, nb, mk->nr, b_pack);
+        for (int ic = 0; ic < M; ic += tiles->mc) {
+          int mb = min_int(tiles->mc, M - ic);
+          pack_a(A, lda, transA, alpha, ic, mb, kc, kb, mk->mr, a_pack);
+          macro_kernel(mk, mk->kernel, a_pack, b_pack, C, ldc, ic, mb, jc,
+                       nb, kb);
+        }
+      }
+    }
+  }
+}
+
+void hpc_gemm_i32(GemmTrans transA, GemmTrans transB, int M, int N, int K,
+                  int32_t alpha, const int32_t *A, int lda, const int32_t *B,
+                  int ldb, int32_t beta, int32_t *C, int ldc) {
+  hpc_gemm_i32_tiles(transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C,
+                     ldc, &default_tiles);
+}
+
+void gemm_acc(int M, int N, int K, const int32_t *A, int lda,
+              const int32_t *B, int ldb, GemmLayout layout,
+              int32_t *C, int ldc, const TileConfig *tiles) {
+  hpc_gemm_i32_tiles(GEMM_NO_TRANS, gemm_trans_b(layout), M, N, K, 1, A, lda,
+                     B, ldb, 1, C, ldc, tiles);
+}
+
+void gemm_block(const int32_t *A, const int32_t *B, int32_t *C, int n,
+                GemmLayout layout, int i0, int i1, int j0, int j1,
+                const TileConfig *tiles) {
+  const int32_t *b = (layout == GEMM_B_TRANSPOSED) ? B + (size_t)j0 * n
+                                                   : B + j0;
+  hpc_gemm_i32_tiles(GEMM_NO_TRANS, gemm_trans_b(layout), i1 - i0, j1 - j0, n,
+                     1, A + (size_t)i0 * n, n, b, n, 0,
+                     C + (size_t)i0 * n + j0, n, tiles);
+}
+
+void gemm_rows(const int32_t *A, const int32_t *B, int32_t *C, int n,
+               GemmLayout layout, int i0, int i1, const TileConfig *tiles) {
+  gemm_block(A, B, C, n, layout, i0, i1, 0, n, tiles);
+}
+
+int gemm_narrow_enabled(void) {
+  const char *value = getenv("GEMM_NARROW");
+  return value != NULL && atoi(value) > 0;
+}
+
+GemmElem gemm_narrow_elem(const int32_t *A, const int32_t *B, size_t count) {
+  int32_t lo = INT32_MAX, hi = INT32_MIN;
+
+  #pragma omp parallel for reduction(min: lo) reduction(max: hi)
+  for (size_t i = 0; i < count; i++) {
+    lo = (A[i] < lo) ? A[i] : lo;
+    hi = (A[i] > hi) ? A[i] : hi;
+    lo = (B[i] < lo) ? B[i] : lo;
+    hi = (B[i] > hi) ? B[i] : hi;
+  }
+
+  if (lo >= INT8_MIN && hi <= INT8_MAX) {
+    return GEMM_INT8;
+  }
+  if (lo > INT16_MIN && hi <= INT16_MAX) {
+    return GEMM_INT16;
+  }
+  return GEMM_INT32;
+}
+
+void *gemm_narrow_copy(const int32_t *M, size_t count, GemmElem elem) {
+  void *copy = malloc((count * elem + 3) / 4 * 4);
+  if (!copy) {
+    return NULL;
+  }
+
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < count; i++) {
+    if (elem == GEMM_INT8) {
+      ((int8_t *)copy)[i] = (int8_t)M[i];
+    } else if (elem == GEMM_INT16) {
+      ((int16_t *)copy)[i] = (int16_t)M[i];
+    } else {
+      ((int32_t *)copy)[i] = M[i];
+    }
+  }
+  return copy;
+}
+
+int32_t gemm_narrow_at(const void *M, GemmElem elem, size_t i) {
+  if (elem == GEMM_INT8) {
+    return ((const int8_t *)M)[i];
+  }
+  if (elem == GEMM_INT16) {
+    return ((const int16_t *)M)[i];
+  }
+  return ((const int32_t *)M)[i];
+}
+
+// Dos valores consecutivos en k en un entero: el de k par en la mitad baja
+static inline int32_t make_pair(int32_t lo, int32_t hi) {
+  return (int32_t)((uint32_t)(uint16_t)lo | ((uint32_t)(uint16_t)hi << 16));
+}
+
+// Como pack_a, pero cada entero del panel lleva los pares (k, k + 1)
+// de int16; con kb impar el último par se completa con cero
+static void pack_a_pairs(const void *A, GemmElem elem, int lda, int i0, int mb,
+                         int k0, int kb, int mr, int32_t *buf) {
+  int pares = (kb + 1) / 2;
+  for (int p = 0; p < mb; p += mr) {
+    int filas = min_int(mr, mb - p);
+    for (int k = 0; k < pares; k++) {
+      int ka = k0 + 2 * k;
+      for (int i = 0; i < filas; i++) {
+        size_t fila = (size_t)(i0 + p + i) * lda;
+        int32_t lo = gemm_narrow_at(A, elem, fila + ka);
+        int32_t hi = (2 * k + 1 < kb) ? gemm_narrow_at(A, elem, fila + ka + 1) : 0;
+        buf[k * mr + i] = make_pair(lo, hi);
+      }
+      for (int i = filas; i < mr; i++) {
+        buf[k * mr + i] = 0;
+      }
+    }
+    buf += (size_t)pares * mr;
+  }
+}
+
+// Como pack_b, con pares de int16 en k. Con B transpuesta los dos
+// elementos del par son contiguos en memoria
+static void pack_b_pairs(const void *B, GemmElem elem, int ldb,
+                         GemmLayout layout, int k0, int kb, int j0, int nb,
+                         int nr, int32_t *buf) {
+  int pares = (kb + 1) / 2;
+  for (int p = 0; p < nb; p += nr) {
+    int cols = min_int(nr, nb - p);
+    for (int k = 0; k < pares; k++) {
+      int ka = k0 + 2 * k;
+      int impar = (2 * k + 1 < kb);
+      for (int j = 0; j < cols; j++) {
+        size_t e0, e1;
+        if (layout == GEMM_B_TRANSPOSED) {
+          e0 = (size_t)(j0 + p + j) * ldb + ka;
+          e1 = e0 + 1;
+        } else {
+          e0 = (size_t)ka * ldb + j0 + p + j;
+          e1 = e0 + ldb;
+        }
+        int32_t lo = gemm_narrow_at(B, elem, e0);
+        int32_t hi = impar ? gemm_narrow_at(B, elem, e1) : 0;
+        buf[k * nr + j] = make_pair(lo, hi);
+      }
+      for (int j = cols; j < nr; j++) {
+        buf[k * nr + j] = 0;
+      }
+    }
+    buf += (size_t)pares * nr;
+  }
+}
+
+void gemm_acc_narrow(int M, int N, int K, const void *A, int lda,
+                     const void *B, int ldb, GemmElem elem, GemmLayout layout,
+                     int32_t *C, int ldc, const TileConfig *tiles) {
+  if (elem == GEMM_INT32) {
+    gemm_acc(M, N, K, (const int32_t *)A, lda, (const int32_t *)B, ldb,
+             layout, C, ldc, tiles);
+    return;
+  }
+
+  // Los paneles de pares ocupan la mitad que los de int32
+  const MicroKernel *mk = gemm_microkernel();
+  int pares_kc = (tiles->kc + 1) / 2;
+  size_t a_size = (size_t)round_up(tiles->mc, mk->mr) * pares_kc * sizeof(int32_t);
+  size_t b_size = (size_t)round_up(tiles->nc, mk->nr) * pares_kc * sizeof(int32_t);
+  int32_t *a_pack = pack_buffer(&pack_cache.a, a_size);
+  int32_t *b_pack = pack_buffer(&pack_cache.b, b_size);
+
+  if (!a_pack || !b_pack) {
+    for (int i = 0; i < M; i++) {
+      for (int j = 0; j < N; j++) {
+        int32_t sum = 0;
+        for (int k = 0; k < K; k++) {
+          size_t eb = (layout == GEMM_B_TRANSPOSED) ? (size_t)j * ldb + k
+                                                    : (size_t)k * ldb + j;
+          sum += gemm_narrow_at(A, elem, (size_t)i * lda + k) *
+                 gemm_narrow_at(B, elem, eb);
+        }
+        C[(size_t)i * ldc + j] += sum;
+      }
+    }
+    return;
+  }
+
+  for (int jc = 0; jc < N; jc += tiles->nc) {
+    int nb = min_int(tiles->nc, N - jc);
+    for (int kc = 0; kc < K; kc += tiles->kc) {
+      int kb = min_int(tiles->kc, K - kc);
+      pack_b_pairs(B, elem, ldb, layout, kc, kb, jc, nb, mk->nr, b_pack);
+      for (int ic = 0; ic < M; ic += tiles->mc) {
+        int mb = min_int(tiles->mc, M - ic);
+        pack_a_pairs(A, elem, lda, ic, mb, kc, kb, mk->mr, a_pack);
+        macro_kernel(mk, mk->kernel16, a_pack, b_pack, C, ldc, ic, mb, jc, nb,
+                     (kb + 1) / 2);
+      }
+    }
+  }
+}
+
+void gemm_block_narrow(const void *A, const void *B, GemmElem elem,
+                       int32_t *C, int n, GemmLayout layout, int i0, int i1,
+                       int j0, int j1, const TileConfig *tiles) {
+  for (int i = i0; i < i1; i++) {
+    memset(C + (size_t)i * n + j0, 0, (size_t)(j1 - j0) * sizeof(int32_t));
+  }
+
+  size_t b_off = (layout == GEMM_B_TRANSPOSED) ? (size_t)j0 * n : (size_t)j0;
+  gemm_acc_narrow(i1 - i0, j1 - j0, n, (const char *)A + (size_t)i0 * n * elem,
+                  n, (const char *)B + b_off * elem, n, elem, layout,
+                  C + (size_t)i0 * n + j0, n, tiles);
+}
+
+void gemm_rows_narrow(const void *A, const void *B, GemmElem elem, int32_t *C,
+                      int n, GemmLayout layout, int i0, int i1,
+                      const TileConfig *tiles) {
+  gemm_block_narrow(A, B, elem, C, n, layout, i0, i1, 0, n, tiles);
+}
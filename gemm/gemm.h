@@ -0,0 +1,139 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Disposicion de B en memoria
+typedef enum {
+  GEMM_B_NORMAL = 0,    // B[k * n + j]
+  GEMM_B_TRANSPOSED = 1 // B[j * n + k] (B se asume transpuesta)
+} GemmLayout;
+
+// Operandos de hpc_gemm_i32, como en BLAS: con GEMM_TRANS se usa la
+// traspuesta de la matriz guardada
+typedef enum {
+  GEMM_NO_TRANS = 0,
+  GEMM_TRANS = 1
+} GemmTrans;
+
+// B guardada con GEMM_B_TRANSPOSED es op(B) con GEMM_TRANS
+static inline GemmTrans gemm_trans_b(GemmLayout layout) {
+  return (layout == GEMM_B_TRANSPOSED) ? GEMM_TRANS : GEMM_NO_TRANS;
+}
+
+// Orden de los bucles de bloques de hpc_gemm_i32 (GEMM_ORDER)
+typedef enum {
+  GEMM_ORDER_JKI = 0, // jc -> kc -> ic: cada panel de B se empaqueta una vez
+  GEMM_ORDER_IKJ = 1  // ic -> kc -> jc: cada panel de A se empaqueta una vez
+} GemmLoopOrder;
+
+// Tamaños de bloque del kernel
+//   mc: filas de A/C por bloque (L2)
+//   nc: columnas de B/C por bloque (L3)
+//   kc: longitud del bloque en la dimension comun (L1)
+typedef struct {
+  int mc;
+  int nc;
+  int kc;
+  GemmLoopOrder order;
+} TileConfig;
+
+// Valores por defecto (o los del perfil de ajuste cargado con
+// tune_select), sobreescribibles con GEMM_MC, GEMM_NC, GEMM_KC y
+// GEMM_ORDER=jki|ikj
+void gemm_tiles_init(TileConfig *tiles);
+
+// Cambiar los valores por defecto de gemm_tiles_init y los bloques de
+// hpc_gemm_i32 (las variables de entorno siguen mandando)
+void gemm_tiles_set_base(const TileConfig *tiles);
+
+const char *gemm_order_name(GemmLoopOrder order);
+
+// "jki" o "ikj"; devuelve 0 si el nombre no es válido
+int gemm_order_parse(const char *name, GemmLoopOrder *order);
+
+// Numero de bloques de tamaño 'block' necesarios para cubrir 'n'
+static inline int gemm_num_blocks(int n, int block) {
+  return (n + block - 1) / block;
+}
+
+// C = alpha * op(A) * op(B) + beta * C con matrices por filas, estilo
+// BLAS: op(A) es M x K, op(B) es K x N y C es M x N; lda, ldb y ldc son
+// las distancias entre filas de las matrices guardadas, así que sirven
+// vistas de submatrices sin copiarlas. Con beta 0 no se lee C. La
+// aritmética es la de int32 (módulo 2^32). Los tamaños de bloque son los
+// de GEMM_MC, GEMM_NC y GEMM_KC, leídos al iniciar el programa
+void hpc_gemm_i32(GemmTrans transA, GemmTrans transB, int M, int N, int K,
+                  int32_t alpha, const int32_t *A, int lda, const int32_t *B,
+                  int ldb, int32_t beta, int32_t *C, int ldc);
+
+// Igual, con tamaños de bloque explícitos
+void hpc_gemm_i32_tiles(GemmTrans transA, GemmTrans transB, int M, int N,
+                        int K, int32_t alpha, const int32_t *A, int lda,
+                        const int32_t *B, int ldb, int32_t beta, int32_t *C,
+                        int ldc, const TileConfig *tiles);
+
+// C[i0:i1, j0:j1] += A[i0:i1, k0:k1] * B[k0:k1, j0:j1], sin bloqueo interno
+void gemm_tile(const int32_t *A, const int32_t *B, int32_t *C, int n,
+               GemmLayout layout, int i0, int i1, int j0, int j1,
+               int k0, int k1);
+
+// C[M x N] += A[M x K] * B[K x N] sobre vistas con distancia entre filas
+// lda, ldb y ldc; con GEMM_B_TRANSPOSED se lee B[j * ldb + k]. Es
+// hpc_gemm_i32 con alpha = beta = 1
+void gemm_acc(int M, int N, int K, const int32_t *A, int lda,
+              const int32_t *B, int ldb, GemmLayout layout,
+              int32_t *C, int ldc, const TileConfig *tiles);
+
+// C[i0:i1, j0:j1] = A[i0:i1, :] * B[:, j0:j1], bloqueado en i, j y k
+void gemm_block(const int32_t *A, const int32_t *B, int32_t *C, int n,
+                GemmLayout layout, int i0, int i1, int j0, int j1,
+                const TileConfig *tiles);
+
+// C[i0:i1, :] = A[i0:i1, :] * B
+void gemm_rows(const int32_t *A, const int32_t *B, int32_t *C, int n,
+               GemmLayout layout, int i0, int i1, const TileConfig *tiles);
+
+// Modo estrecho (GEMM_NARROW=1): A y B se guardan con el tipo más estrecho
+// en el que caben sus valores y el micro-kernel multiplica pares de int16
+// acumulando en int32 (pmaddwd). El valor del enum es el tamaño en bytes;
+// C siempre es int32
+typedef enum {
+  GEMM_INT8 = 1,
+  GEMM_INT16 = 2,
+  GEMM_INT32 = 4
+} GemmElem;
+
+int gemm_narrow_enabled(void);
+
+// Tipo común más estrecho para los count valores de A y los de B. int16
+// excluye -32768: 2 * (-32768)^2 no cabe en la suma de pmaddwd
+GemmElem gemm_narrow_elem(const int32_t *A, const int32_t *B, size_t count);
+
+// Copia de M con elementos de tipo elem (NULL si falta memoria). Ocupa un
+// número entero de int32, para poder replicarla con replicate_per_node
+void *gemm_narrow_copy(const int32_t *M, size_t count, GemmElem elem);
+
+// Elemento i de una matriz de tipo elem
+int32_t gemm_narrow_at(const void *M, GemmElem elem, size_t i);
+
+// gemm_acc, gemm_block y gemm_rows con A y B de tipo elem (lda y ldb en
+// elementos). Con GEMM_INT32 usan el kernel normal; con los tipos
+// estrechos el resultado es el mismo que con int32
+void gemm_acc_narrow(int M, int N, int K, const void *A, int lda,
+                     const void *B, int ldb, GemmElem elem, GemmLayout layout,
+                     int32_t *C, int ldc, const TileConfig *tiles);
+void gemm_block_narrow(const void *A, const void *B, GemmElem elem,
+                       int32_t *C, int n, GemmLayout layout, int i0, int i1,
+                       int j0, int j1, const TileConfig *tiles);
+void gemm_rows_narrow(const void *A, const void *B, GemmElem elem, int32_t *C,
+                      int n, GemmLayout layout, int i0, int i1,
+                      const TileConfig *tiles);
+
+// C = A * B con Strassen-Winograd; por debajo de 'corte' usa gemm_rows.
+// Llamada desde un bloque single reparte los productos en tasks de OpenMP.
+void gemm_strassen(const int32_t *A, const int32_t *B, int32_t *C, int n,
+                   GemmLayout layout, int corte, const TileConfig *tiles);
+
+#endif
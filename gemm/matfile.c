@@ -0,0 +1,286 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "matfile.h"
+#include "rng.h"
+
+#define MATFILE_MAGIC "GEMMMAT"
+
+_Static_assert(sizeof(MatFileHeader) == MATFILE_ALIGN,
+               "la cabecera ocupa exactamente un bloque alineado");
+
+#define FNV_PRIME 0x100000001b3ULL
+
+// FNV-1a sobre palabras de 32 bits en cuatro carriles independientes (la
+// cadena de multiplicaciones de un solo carril limita la velocidad): el
+// elemento i va al carril i % 4
+void matfile_checksum_init(MatChecksum *c) {
+  c->h[0] = 0xcbf29ce484222325ULL;
+  c->h[1] = 0x84222325cbf29ce4ULL;
+  c->h[2] = 0x9e3779b97f4a7c15ULL;
+  c->h[3] = 0xc2b2ae3d27d4eb4fULL;
+  c->count = 0;
+}
+
+void matfile_checksum_update(MatChecksum *c, const int32_t *data, size_t count) {
+  size_t i = 0;
+  for (; i < count && (c->count + i) % 4 != 0; i++) {
+    int l = (c->count + i) % 4;
+    c->h[l] = (c->h[l] ^ (uint32_t)data[i]) * FNV_PRIME;
+  }
+  for (; i + 4 <= count; i += 4) {
+    for (int l = 0; l < 4; l++) {
+      c->h[l] = (c->h[l] ^ (uint32_t)data[i + l]) * FNV_PRIME;
+    }
+  }
+  for (int l = 0; i < count; i++, l++) {
+    c->h[l] = (c->h[l] ^ (uint32_t)data[i]) * FNV_PRIME;
+  }
+  c->count += count;
+}
+
+uint64_t matfile_checksum_final(const MatChecksum *c) {
+  uint64_t r = c->h[0];
+  for (int l = 1; l < 4; l++) {
+    r = (r ^ c->h[l]) * FNV_PRIME;
+  }
+  return r;
+}
+
+uint64_t matfile_checksum(const int32_t *data, size_t count) {
+  MatChecksum c;
+  matfile_checksum_init(&c);
+  matfile_checksum_update(&c, data, count);
+  return matfile_checksum_final(&c);
+}
+
+static size_t payload_bytes(const MatFileHeader *h) {
+  return (size_t)h->rows * h->cols * sizeof(int32_t);
+}
+
+// Motivo por el que la cabecera no vale para un fichero de file_size
+// bytes, o NULL si vale
+static const char *check_header(const MatFileHeader *h, size_t file_size) {
+  if (memcmp(h->magic, MATFILE_MAGIC, sizeof(MATFILE_MAGIC)) != 0) {
+    return "no es un fichero de matriz (o no se termino de escribir)";
+  }
+  if (h->version != MATFILE_VERSION || h->dtype != MATFILE_INT32) {
+    return "version o tipo de dato no soportados";
+  }
+  if (h->tile != 0) {
+    return "las matrices teseladas no estan soportadas";
+  }
+  if (h->rows == 0 || h->cols == 0 || h->rows > INT_MAX ||
+      h->cols > INT_MAX) {
+    return "dimensiones no validas";
+  }
+  // Sin multiplicar rows * cols: con una cabecera dañada se desbordaría
+  if (h->data_offset % MATFILE_ALIGN != 0 || h->data_offset > file_size ||
+      h->rows > (file_size - h->data_offset) / sizeof(int32_t) / h->cols) {
+    return "fichero truncado";
+  }
+  return NULL;
+}
+
+// Cabecera de un fichero nuevo, sin magic ni checksum todavía
+static void init_header(MatFileHeader *h, int rows, int cols,
+                        GemmLayout layout) {
+  memset(h, 0, sizeof(*h));
+  h->version = MATFILE_VERSION;
+  h->dtype = MATFILE_INT32;
+  h->layout = layout;
+  h->rows = rows;
+  h->cols = cols;
+  h->data_offset = sizeof(MatFileHeader);
+}
+
+int32_t *matfile_open(const char *path, MatFile *mf) {
+  memset(mf, 0, sizeof(*mf));
+  mf->fd = open(path, O_RDONLY);
+  if (mf->fd < 0) {
+    perror(path);
+    return NULL;
+  }
+
+  struct stat st;
+  if (fstat(mf->fd, &st) != 0 || (size_t)st.st_size < sizeof(MatFileHeader)) {
+    fprintf(stderr, "%s: no es un fichero de matriz\n", path);
+    close(mf->fd);
+    return NULL;
+  }
+
+  mf->map_size = st.st_size;
+  mf->map = mmap(NULL, mf->map_size, PROT_READ, MAP_SHARED, mf->fd, 0);
+  if (mf->map == MAP_FAILED) {
+    perror(path);
+    close(mf->fd);
+    return NULL;
+  }
+
+  const MatFileHeader *h = (const MatFileHeader *)mf->map;
+  const char *error = check_header(h, mf->map_size);
+
+  if (!error) {
+    mf->header = (MatFileHeader *)mf->map;
+    mf->data = (int32_t *)((char *)mf->map + h->data_offset);
+    if (matfile_checksum(mf->data, (size_t)h->rows * h->cols) != h->checksum) {
+      error = "checksum incorrecto";
+    }
+  }
+
+  if (error) {
+    fprintf(stderr, "%s: %s\n", path, error);
+    munmap(mf->map, mf->map_size);
+    close(mf->fd);
+    memset(mf, 0, sizeof(*mf));
+    return NULL;
+  }
+  return mf->data;
+}
+
+int32_t *matfile_create(const char *path, int rows, int cols,
+                        GemmLayout layout, MatFile *mf) {
+  memset(mf, 0, sizeof(*mf));
+  mf->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (mf->fd < 0) {
+    perror(path);
+    return NULL;
+  }
+
+  size_t offset = sizeof(MatFileHeader);
+  mf->map_size = offset + (size_t)rows * cols * sizeof(int32_t);
+  if (ftruncate(mf->fd, mf->map_size) != 0) {
+    perror(path);
+    close(mf->fd);
+    return NULL;
+  }
+
+  mf->map = mmap(NULL, mf->map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                 mf->fd, 0);
+  if (mf->map == MAP_FAILED) {
+    perror(path);
+    close(mf->fd);
+    return NULL;
+  }
+
+  // Magic y checksum se escriben en matfile_close
+  mf->writable = 1;
+  mf->header = (MatFileHeader *)mf->map;
+  init_header(mf->header, rows, cols, layout);
+  mf->data = (int32_t *)((char *)mf->map + offset);
+  return mf->data;
+}
+
+int matfile_open_fd(const char *path, MatFileHeader *h) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    perror(path);
+    return -1;
+  }
+
+  struct stat st;
+  const char *error = NULL;
+  if (fstat(fd, &st) != 0 ||
+      pread(fd, h, sizeof(*h), 0) != (ssize_t)sizeof(*h)) {
+    error = "no es un fichero de matriz";
+  } else {
+    error = check_header(h, st.st_size);
+  }
+
+  if (error) {
+    fprintf(stderr, "%s: %s\n", path, error);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int matfile_create_fd(const char *path, int rows, int cols, GemmLayout layout,
+                      MatFileHeader *h) {
+  int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    perror(path);
+    return -1;
+  }
+
+  init_header(h, rows, cols, layout);
+  if (ftruncate(fd, h->data_offset + payload_bytes(h)) != 0) {
+    perror(path);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int matfile_finish_fd(int fd, MatFileHeader *h, uint64_t checksum) {
+  h->checksum = checksum;
+  memcpy(h->magic, MATFILE_MAGIC, sizeof(MATFILE_MAGIC));
+  int ok = pwrite(fd, h, sizeof(*h), 0) == (ssize_t)sizeof(*h);
+  return (close(fd) == 0) && ok;
+}
+
+int matfile_close(MatFile *mf) {
+  if (!mf->map) {
+    return 1;
+  }
+
+  if (mf->writable) {
+    MatFileHeader *h = mf->header;
+    h->checksum = matfile_checksum(mf->data, (size_t)h->rows * h->cols);
+    memcpy(h->magic, MATFILE_MAGIC, sizeof(MATFILE_MAGIC));
+  }
+
+  int ok = munmap(mf->map, mf->map_size) == 0;
+  ok = (close(mf->fd) == 0) && ok;
+  memset(mf, 0, sizeof(*mf));
+  return ok;
+}
+
+int matfile_release(MatFile *mf, int32_t *M) {
+  if (mf->data != NULL && M == mf->data) {
+    return matfile_close(mf);
+  }
+  free(M);
+  return 1;
+}
+
+int matfile_operand(const char *var, int n, uint64_t seed, int id, MatFile *mf) {
+  memset(mf, 0, sizeof(*mf));
+  const char *path = getenv(var);
+  if (path == NULL || *path == '\0') {
+    return 1;
+  }
+
+  if (access(path, F_OK) != 0) {
+    if (!matfile_create(path, n, n, GEMM_B_NORMAL, mf)) {
+      return 0;
+    }
+    generate_matrix_philox(mf->data, n, seed, id, GEMM_B_NORMAL);
+    return 1;
+  }
+
+  if (!matfile_open(path, mf)) {
+    return 0;
+  }
+  if (mf->header->rows != (uint64_t)n || mf->header->cols != (uint64_t)n ||
+      mf->header->layout != GEMM_B_NORMAL) {
+    fprintf(stderr, "%s: se esperaba una matriz %dx%d por filas\n", path, n, n);
+    matfile_close(mf);
+    return 0;
+  }
+  return 1;
+}
+
+int matfile_result(int n, MatFile *mf) {
+  memset(mf, 0, sizeof(*mf));
+  const char *path = getenv("GEMM_C_FILE");
+  if (path == NULL || *path == '\0') {
+    return 1;
+  }
+  return matfile_create(path, n, n, GEMM_B_NORMAL, mf) != NULL;
+}
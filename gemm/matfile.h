@@ -0,0 +1,89 @@
+#ifndef MATFILE_H
+#define MATFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "gemm.h"
+
+// Fichero binario de matriz: cabecera de 64 bytes seguida del contenido,
+// alineado a 64 bytes, para poder mapearlo con mmap y usarlo sin copias ni
+// conversión de texto
+#define MATFILE_VERSION 1
+#define MATFILE_INT32 1
+#define MATFILE_ALIGN 64
+
+typedef struct {
+  char magic[8];        // "GEMMMAT" (se escribe al cerrar: un fichero a
+                        // medio escribir no se puede abrir)
+  uint32_t version;
+  uint32_t dtype;       // MATFILE_INT32
+  uint32_t layout;      // GemmLayout del contenido
+  uint32_t tile;        // lado de tesela; 0 = sin teselar
+  uint64_t rows;
+  uint64_t cols;
+  uint64_t checksum;    // del contenido (matfile_checksum)
+  uint64_t data_offset; // múltiplo de MATFILE_ALIGN
+  uint8_t reserved[8];
+} MatFileHeader;
+
+// Fichero abierto y mapeado; data apunta al contenido dentro del mapeo
+typedef struct {
+  int fd;
+  void *map;
+  size_t map_size;
+  int writable;
+  MatFileHeader *header;
+  int32_t *data;
+} MatFile;
+
+// Checksum del contenido, calculable por partes consecutivas
+typedef struct {
+  uint64_t h[4];
+  uint64_t count;
+} MatChecksum;
+
+void matfile_checksum_init(MatChecksum *c);
+void matfile_checksum_update(MatChecksum *c, const int32_t *data, size_t count);
+uint64_t matfile_checksum_final(const MatChecksum *c);
+uint64_t matfile_checksum(const int32_t *data, size_t count);
+
+// Mapear un fichero existente en solo lectura, comprobando cabecera y
+// checksum. Devuelve NULL (con el motivo en stderr) si no es válido
+int32_t *matfile_open(const char *path, MatFile *mf);
+
+// Crear (o truncar) un fichero rows x cols y mapearlo para escritura: lo
+// que se escriba en el resultado acaba en el fichero. NULL si falla
+int32_t *matfile_create(const char *path, int rows, int cols,
+                        GemmLayout layout, MatFile *mf);
+
+// Desmapear; si se creó para escritura, completar antes la cabecera con
+// el checksum. Devuelve 0 si falla
+int matfile_close(MatFile *mf);
+
+// Acceso por descriptor, sin mapear, para leer o escribir por partes con
+// pread/pwrite (modo fuera de núcleo). matfile_open_fd comprueba la
+// cabecera pero no el checksum, que obligaría a leer el fichero entero;
+// devuelve el descriptor o -1. matfile_create_fd crea el fichero con su
+// tamaño final y matfile_finish_fd escribe la cabecera con el checksum
+// del contenido y lo cierra (0 si falla)
+int matfile_open_fd(const char *path, MatFileHeader *h);
+int matfile_create_fd(const char *path, int rows, int cols, GemmLayout layout,
+                      MatFileHeader *h);
+int matfile_finish_fd(int fd, MatFileHeader *h, uint64_t checksum);
+
+// Operando n x n de los programas, nombrado por la variable de entorno
+// 'var' (GEMM_A_FILE, GEMM_B_FILE): si el fichero existe se mapea; si no,
+// se crea, se genera allí la matriz 'id' y queda guardada para las
+// siguientes ejecuciones. Sin la variable deja mf->data a NULL.
+// Devuelve 0 si el fichero no vale
+int matfile_operand(const char *var, int n, uint64_t seed, int id, MatFile *mf);
+
+// Liberar una matriz de los programas: si es la de mf se desmapea con
+// matfile_close y si no, con free. Devuelve 0 si falla
+int matfile_release(MatFile *mf, int32_t *M);
+
+// Resultado n x n mapeado sobre el fichero de GEMM_C_FILE (mf->data a NULL
+// si no está definida). Devuelve 0 si no se puede crear
+int matfile_result(int n, MatFile *mf);
+
+#endif
@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+#include "microkernel.h"
+
+// Version portable, usada cuando la CPU no tiene SSE4.1
+#define GENERIC_MR 4
+#define GENERIC_NR 4
+
+static void kernel_generic(int kc, const int32_t *a, const int32_t *b,
+                           int32_t *c, int ldc) {
+  int32_t acc[GENERIC_MR][GENERIC_NR] = {{0}};
+
+  for (int k = 0; k < kc; k++) {
+    for (int i = 0; i < GENERIC_MR; i++) {
+      for (int j = 0; j < GENERIC_NR; j++) {
+        acc[i][j] += a[k * GENERIC_MR + i] * b[k * GENERIC_NR + j];
+      }
+    }
+  }
+
+  for (int i = 0; i < GENERIC_MR; i++) {
+    for (int j = 0; j < GENERIC_NR; j++) {
+      c[i * ldc + j] += acc[i][j];
+    }
+  }
+}
+
+// Pares de int16 de un entero empaquetado
+static inline int32_t pair_lo(int32_t p) {
+  return (int16_t)(p & 0xFFFF);
+}
+
+static inline int32_t pair_hi(int32_t p) {
+  return (int16_t)((uint32_t)p >> 16);
+}
+
+static void kernel16_generic(int kc, const int32_t *a, const int32_t *b,
+                             int32_t *c, int ldc) {
+  int32_t acc[GENERIC_MR][GENERIC_NR] = {{0}};
+
+  for (int k = 0; k < kc; k++) {
+    for (int i = 0; i < GENERIC_MR; i++) {
+      int32_t ai = a[k * GENERIC_MR + i];
+      for (int j = 0; j < GENERIC_NR; j++) {
+        int32_t bj = b[k * GENERIC_NR + j];
+        acc[i][j] += pair_lo(ai) * pair_lo(bj) + pair_hi(ai) * pair_hi(bj);
+      }
+    }
+  }
+
+  for (int i = 0; i < GENERIC_MR; i++) {
+    for (int j = 0; j < GENERIC_NR; j++) {
+      c[i * ldc + j] += acc[i][j];
+    }
+  }
+}
+
+// SSE4.1: 4x8, dos registros de 4 enteros por fila (pmulld + paddd)
+#define SSE_MR 4
+#define SSE_NR 8
+
+__attribute__((target("sse4.1")))
+static void kernel_sse41(int kc, const int32_t *a, const int32_t *b,
+                         int32_t *c, int ldc) {
+  __m128i acc[SSE_MR][2];
+  for (int i = 0; i < SSE_MR; i++) {
+    acc[i][0] = _mm_setzero_si128();
+    acc[i][1] = _mm_setzero_si128();
+  }
+
+  for (int k = 0; k < kc; k++) {
+    __m128i b0 = _mm_load_si128((const __m128i *)(b + k * SSE_NR));
+    __m128i b1 = _mm_load_si128((const __m128i *)(b + k * SSE_NR + 4));
+    for (int i = 0; i < SSE_MR; i++) {
+      __m128i ai = _mm_set1_epi32(a[k * SSE_MR + i]);
+      acc[i][0] = _mm_add_epi32(acc[i][0], _mm_mullo_epi32(ai, b0));
+      acc[i][1] = _mm_add_epi32(acc[i][1], _mm_mullo_epi32(ai, b1));
+    }
+  }
+
+  for (int i = 0; i < SSE_MR; i++) {
+    __m128i *ci = (__m128i *)(c + i * ldc);
+    _mm_storeu_si128(ci, _mm_add_epi32(_mm_loadu_si128(ci), acc[i][0]));
+    _mm_storeu_si128(ci + 1, _mm_add_epi32(_mm_loadu_si128(ci + 1), acc[i][1]));
+  }
+}
+
+__attribute__((target("sse4.1")))
+static void kernel16_sse41(int kc, const int32_t *a, const int32_t *b,
+                           int32_t *c, int ldc) {
+  __m128i acc[SSE_MR][2];
+  for (int i = 0; i < SSE_MR; i++) {
+    acc[i][0] = _mm_setzero_si128();
+    acc[i][1] = _mm_setzero_si128();
+  }
+
+  for (int k = 0; k < kc; k++) {
+    __m128i b0 = _mm_load_si128((const __m128i *)(b + k * SSE_NR));
+    __m128i b1 = _mm_load_si128((const __m128i *)(b + k * SSE_NR + 4));
+    for (int i = 0; i < SSE_MR; i++) {
+      __m128i ai = _mm_set1_epi32(a[k * SSE_MR + i]);
+      acc[i][0] = _mm_add_epi32(acc[i][0], _mm_madd_epi16(ai, b0));
+      acc[i][1] = _mm_add_epi32(acc[i][1], _mm_madd_epi16(ai, b1));
+    }
+  }
+
+  for (int i = 0; i < SSE_MR; i++) {
+    __m128i *ci = (__m128i *)(c + i * ldc);
+    _mm_storeu_si128(ci, _mm_add_epi32(_mm_loadu_si128(ci), acc[i][0]));
+    _mm_storeu_si128(ci + 1, _mm_add_epi32(_mm_loadu_si128(ci + 1), acc[i][1]));
+  }
+}
+
+// AVX2: 6x16, 12 acumuladores de 8 enteros
+#define AVX2_MR 6
+#define AVX2_NR 16
+
+__attribute__((target("avx2")))
+static void kernel_avx2(int kc, const int32_t *a, const int32_t *b,
+                        int32_t *c, int ldc) {
+  __m256i acc[AVX2_MR][2];
+  for (int i = 0; i < AVX2_MR; i++) {
+    acc[i][0] = _mm256_setzero_si256();
+    acc[i][1] = _mm256_setzero_si256();
+  }
+
+  for (int k = 0; k < kc; k++) {
+    __m256i b0 = _mm256_load_si256((const __m256i *)(b + k * AVX2_NR));
+    __m256i b1 = _mm256_load_si256((const __m256i *)(b + k * AVX2_NR + 8));
+    for (int i = 0; i < AVX2_MR; i++) {
+      __m256i ai = _mm256_set1_epi32(a[k * AVX2_MR + i]);
+      acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_mullo_epi32(ai, b0));
+      acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_mullo_epi32(ai, b1));
+    }
+  }
+
+  for (int i = 0; i < AVX2_MR; i++) {
+    __m256i *ci = (__m256i *)(c + i * ldc);
+    _mm256_storeu_si256(ci, _mm256_add_epi32(_mm256_loadu_si256(ci), acc[i][0]));
+    _mm256_storeu_si256(ci + 1, _mm256_add_epi32(_mm256_loadu_si256(ci + 1), acc[i][1]));
+  }
+}
+
+__attribute__((target("avx2")))
+static void kernel16_avx2(int kc, const int32_t *a, const int32_t *b,
+                          int32_t *c, int ldc) {
+  __m256i acc[AVX2_MR][2];
+  for (int i = 0; i < AVX2_MR; i++) {
+    acc[i][0] = _mm256_setzero_si256();
+    acc[i][1] = _mm256_setzero_si256();
+  }
+
+  for (int k = 0; k < kc; k++) {
+    __m256i b0 = _mm256_load_si256((const __m256i *)(b + k * AVX2_NR));
+    __m256i b1 = _mm256_load_si256((const __m256i *)(b + k * AVX2_NR + 8));
+    for (int i = 0; i < AVX2_MR; i++) {
+      __m256i ai = _mm256_set1_epi32(a[k * AVX2_MR + i]);
+      acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_madd_epi16(ai, b0));
+      acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_madd_epi16(ai, b1));
+    }
+  }
+
+  for (int i = 0; i < AVX2_MR; i++) {
+    __m256i *ci = (__m256i *)(c + i * ldc);
+    _mm256_storeu_si256(ci, _mm256_add_epi32(_mm256_loadu_si256(ci), acc[i][0]));
+    _mm256_storeu_si256(ci + 1, _mm256_add_epi32(_mm256_loadu_si256(ci + 1), acc[i][1]));
+  }
+}
+
+// AVX-512: 8x32, 16 acumuladores de 16 enteros
+#define AVX512_MR 8
+#define AVX512_NR 32
+
+__attribute__((target("avx512f")))
+static void kernel_avx512(int kc, const int32_t *a, const int32_t *b,
+                          int32_t *c, int ldc) {
+  __m512i acc[AVX512_MR][2];
+  for (int i = 0; i < AVX512_MR; i++) {
+    acc[i][0] = _mm512_setzero_si512();
+    acc[i][1] = _mm512_setzero_si512();
+  }
+
+  for (int k = 0; k < kc; k++) {
+    __m512i b0 = _mm512_load_si512((const void *)(b + k * AVX512_NR));
+    __m512i b1 = _mm512_load_si512((const void *)(b + k * AVX512_NR + 16));
+    for (int i = 0; i < AVX512_MR; i++) {
+      __m512i ai = _mm512_set1_epi32(a[k * AVX512_MR + i]);
+      acc[i][0] = _mm512_add_epi32(acc[i][0], _mm512_mullo_epi32(ai, b0));
+      acc[i][1] = _mm512_add_epi32(acc[i][1], _mm512_mullo_epi32(ai, b1));
+    }
+  }
+
+  for (int i = 0; i < AVX512_MR; i++) {
+    int32_t *ci = c + i * ldc;
+    _mm512_storeu_si512(ci, _mm512_add_epi32(_mm512_loadu_si512(ci), acc[i][0]));
+    _mm512_storeu_si512(ci + 16, _mm512_add_epi32(_mm512_loadu_si512(ci + 16), acc[i][1]));
+  }
+}
+
+// vpmaddwd de 512 bits es AVX-512BW
+__attribute__((target("avx512f,avx512bw")))
+static void kernel16_avx512(int kc, const int32_t *a, const int32_t *b,
+                            int32_t *c, int ldc) {
+  __m512i acc[AVX512_MR][2];
+  for (int i = 0; i < AVX512_MR; i++) {
+    acc[i][0] = _mm512_setzero_si512();
+    acc[i][1] = _mm512_setzero_si512();
+  }
+
+  for (int k = 0; k < kc; k++) {
+    __m512i b0 = _mm512_load_si512((const void *)(b + k * AVX512_NR));
+    __m512i b1 = _mm512_load_si512((const void *)(b + k * AVX512_NR + 16));
+    for (int i = 0; i < AVX512_MR; i++) {
+      __m512i ai = _mm512_set1_epi32(a[k * AVX512_MR + i]);
+      acc[i][0] = _mm512_add_epi32(acc[i][0], _mm512_madd_epi16(ai, b0));
+      acc[i][1] = _mm512_add_epi32(acc[i][1], _mm512_madd_epi16(ai, b1));
+    }
+  }
+
+  for (int i = 0; i < AVX512_MR; i++) {
+    int32_t *ci = c + i * ldc;
+    _mm512_storeu_si512(ci, _mm512_add_epi32(_mm512_loadu_si512(ci), acc[i][0]));
+    _mm512_storeu_si512(ci + 16, _mm512_add_epi32(_mm512_loadu_si512(ci + 16), acc[i][1]));
+  }
+}
+
+static const MicroKernel kernels[] = {
+  { "avx512", AVX512_MR, AVX512_NR, kernel_avx512, kernel16_avx512 },
+  { "avx2", AVX2_MR, AVX2_NR, kernel_avx2, kernel16_avx2 },
+  { "sse4.1", SSE_MR, SSE_NR, kernel_sse41, kernel16_sse41 },
+  { "generic", GENERIC_MR, GENERIC_NR, kernel_generic, kernel16_generic },
+};
+
+#define NUM_KERNELS (int)(sizeof(kernels) / sizeof(kernels[0]))
+
+static const MicroKernel *selected = &kernels[NUM_KERNELS - 1];
+
+static int cpu_supports(const char *name) {
+  if (strcmp(name, "avx512") == 0) {
+    return __builtin_cpu_supports("avx512f") &&
+           __builtin_cpu_supports("avx512bw");
+  }
+  if (strcmp(name, "avx2") == 0) {
+    return __builtin_cpu_supports("avx2");
+  }
+  if (strcmp(name, "sse4.1") == 0) {
+    return __builtin_cpu_supports("sse4.1");
+  }
+  return 1;
+}
+
+// Elegir el micro-kernel una sola vez, antes de main()
+__attribute__((constructor))
+static void select_microkernel(void) {
+  __builtin_cpu_init();
+
+  const char *forced = getenv("GEMM_ISA");
+  if (forced != NULL) {
+    for (int i = 0; i < NUM_KERNELS; i++) {
+      if (strcmp(forced, kernels[i].name) == 0 && cpu_supports(forced)) {
+        selected = &kernels[i];
+        return;
+      }
+    }
+    fprintf(stderr, "GEMM_ISA=%s no disponible, se usa deteccion automatica\n",
+            forced);
+  }
+
+  for (int i = 0; i < NUM_KERNELS; i++) {
+    if (cpu_supports(kernels[i].name)) {
+      selected = &kernels[i];
+      return;
+    }
+  }
+}
+
+const MicroKernel *gemm_microkernel(void) {
+  return selected;
+}
@@ -0,0 +1,29 @@
+#ifndef MICROKERNEL_H
+#define MICROKERNEL_H
+
+#include <stdint.h>
+
+// Micro-kernel: C[mr x nr] += A_panel * B_panel
+//   a: panel empaquetado de A, kc columnas de mr elementos (a[k * mr + i])
+//   b: panel empaquetado de B, kc filas de nr elementos (b[k * nr + j])
+//   c: bloque de C con distancia entre filas ldc
+typedef void (*MicroKernelFn)(int kc, const int32_t *a, const int32_t *b,
+                              int32_t *c, int ldc);
+
+// Variante de 16 bits (modo estrecho): cada entero de a y b lleva dos
+// int16 consecutivos en k (el de k par en la mitad baja) y kc cuenta
+// pares. pmaddwd multiplica los pares y suma los dos productos en int32
+typedef struct {
+  const char *name; // conjunto de instrucciones
+  int mr;           // filas del bloque de registros
+  int nr;           // columnas del bloque de registros
+  MicroKernelFn kernel;
+  MicroKernelFn kernel16;
+} MicroKernel;
+
+// Micro-kernel elegido con cpuid al iniciar el programa.
+// GEMM_ISA=generic|sse4.1|avx2|avx512 fuerza una version concreta
+// (avx512 necesita AVX-512F y BW).
+const MicroKernel *gemm_microkernel(void);
+
+#endif
@@ -0,0 +1,393 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "ooc.h"
+#include "matfile.h"
+#include "rng.h"
+#include "verify.h"
+
+#define OOC_DEFAULT_MB 1024
+
+// Recorrido por pasos s = ip * depth + kp: el paso (ip, kp) acumula en el
+// panel ip de C (rows x n) el producto A[ip, kp] * B[kp, :]. El panel de A
+// (rows x n, contiguo en el fichero) se lee entero al empezar cada ip y el
+// de B (kr x n, contiguo) en cada paso. A, B y C tienen dos buffers: el
+// hilo de E/S llena el del paso s + 1 mientras se calcula el paso s
+typedef struct {
+  int fd_a, fd_b, fd_c;
+  off_t off_a, off_b, off_c;
+  int n;
+  int mb, kb;       // filas por panel de A y C, filas por panel de B
+  int panels;       // paneles de C
+  int depth;        // pasos por panel de C
+  int32_t *a[2], *b[2], *c[2];
+  MatChecksum sum;  // de C, que se escribe en orden
+  const TileConfig *tiles;
+
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  int loaded;       // pasos con A y B ya en memoria
+  int computed;     // pasos calculados
+  int written;      // paneles de C escritos
+  int error;
+  size_t bytes_read;
+} OocState;
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static int panel_rows(const OocState *st, int ip) {
+  int i0 = ip * st->mb;
+  return (i0 + st->mb < st->n) ? st->mb : st->n - i0;
+}
+
+static int panel_depth(const OocState *st, int kp) {
+  int k0 = kp * st->kb;
+  return (k0 + st->kb < st->n) ? st->kb : st->n - k0;
+}
+
+// pread/pwrite completos: pueden devolver menos bytes de los pedidos
+static int read_full(int fd, void *buf, size_t bytes, off_t offset) {
+  char *p = (char *)buf;
+  while (bytes > 0) {
+    ssize_t r = pread(fd, p, bytes, offset);
+    if (r <= 0) {
+      return 0;
+    }
+    p += r;
+    bytes -= r;
+    offset += r;
+  }
+  return 1;
+}
+
+static int write_full(int fd, const void *buf, size_t bytes, off_t offset) {
+  const char *p = (const char *)buf;
+  while (bytes > 0) {
+    ssize_t r = pwrite(fd, p, bytes, offset);
+    if (r <= 0) {
+      return 0;
+    }
+    p += r;
+    bytes -= r;
+    offset += r;
+  }
+  return 1;
+}
+
+// Offset en el fichero de B de la fila k0 (bytes del panel kp)
+static off_t b_offset(const OocState *st, int kp) {
+  return st->off_b + (off_t)kp * st->kb * st->n * sizeof(int32_t);
+}
+
+static int load_step(OocState *st, int s) {
+  int ip = s / st->depth;
+  int kp = s % st->depth;
+  size_t row_bytes = (size_t)st->n * sizeof(int32_t);
+
+  if (kp == 0) {
+    size_t bytes = panel_rows(st, ip) * row_bytes;
+    off_t offset = st->off_a + (off_t)ip * st->mb * row_bytes;
+    if (!read_full(st->fd_a, st->a[ip % 2], bytes, offset)) {
+      return 0;
+    }
+    st->bytes_read += bytes;
+  }
+
+  size_t bytes = panel_depth(st, kp) * row_bytes;
+  if (!read_full(st->fd_b, st->b[s % 2], bytes, b_offset(st, kp))) {
+    return 0;
+  }
+  st->bytes_read += bytes;
+
+  // Adelantar al núcleo la lectura del panel de B que vendrá después del
+  // siguiente, para que el disco no se quede parado entre dos pread
+  int next = (kp + 2) % st->depth;
+  posix_fadvise(st->fd_b, b_offset(st, next),
+                panel_depth(st, next) * row_bytes, POSIX_FADV_WILLNEED);
+  return 1;
+}
+
+static int write_panel(OocState *st, int ip) {
+  size_t count = (size_t)panel_rows(st, ip) * st->n;
+  off_t offset = st->off_c + (off_t)ip * st->mb * st->n * sizeof(int32_t);
+  matfile_checksum_update(&st->sum, st->c[ip % 2], count);
+  return write_full(st->fd_c, st->c[ip % 2], count * sizeof(int32_t), offset);
+}
+
+// Hilo de E/S: escribir un panel de C en cuanto está calculado (libera su
+// buffer) y si no, cargar el siguiente paso cuando su buffer queda libre,
+// es decir, cuando el paso s - 2 ya está calculado
+static void *io_thread(void *arg) {
+  OocState *st = (OocState *)arg;
+  int steps = st->panels * st->depth;
+
+  pthread_mutex_lock(&st->lock);
+  while (st->written < st->panels && !st->error) {
+    int can_write = st->computed >= (st->written + 1) * st->depth;
+    int can_load = st->loaded < steps && st->computed >= st->loaded - 1;
+    if (!can_write && !can_load) {
+      pthread_cond_wait(&st->cond, &st->lock);
+      continue;
+    }
+    pthread_mutex_unlock(&st->lock);
+
+    int ok = can_write ? write_panel(st, st->written)
+                       : load_step(st, st->loaded);
+
+    pthread_mutex_lock(&st->lock);
+    if (!ok) {
+      st->error = 1;
+    } else if (can_write) {
+      st->written++;
+    } else {
+      st->loaded++;
+    }
+    pthread_cond_broadcast(&st->cond);
+  }
+  pthread_mutex_unlock(&st->lock);
+  return NULL;
+}
+
+// C[rows x n] += A[:, k0:k0 + kr] * B_panel[kr x n]. B se usa tal cual se
+// lee, por filas: el empaquetado de hpc_gemm_i32 ya la reordena por bloques
+static void compute_step(const OocState *st, int32_t *C, const int32_t *A,
+                         const int32_t *B, int rows, int kr) {
+  const TileConfig *tiles = st->tiles;
+  int n = st->n;
+  int bloques_i = gemm_num_blocks(rows, tiles->mc);
+  int bloques_j = gemm_num_blocks(n, tiles->nc);
+
+  #pragma omp parallel for collapse(2) schedule(dynamic)
+  for (int bi = 0; bi < bloques_i; bi++) {
+    for (int bj = 0; bj < bloques_j; bj++) {
+      int i0 = bi * tiles->mc;
+      int j0 = bj * tiles->nc;
+      int mb = (i0 + tiles->mc < rows) ? tiles->mc : rows - i0;
+      int nb = (j0 + tiles->nc < n) ? tiles->nc : n - j0;
+      hpc_gemm_i32_tiles(GEMM_NO_TRANS, GEMM_NO_TRANS, mb, nb, kr, 1,
+                         A + (size_t)i0 * n, n, B + j0, n, 1,
+                         C + (size_t)i0 * n + j0, n, tiles);
+    }
+  }
+}
+
+// Tamaño de los paneles para que los seis buffers quepan en el presupuesto.
+// Los dos de B no pasan de la mitad: si se comieran casi todo, los de A y C
+// bajarían a pocas filas y B se releería entero por cada panel
+static void choose_panels(OocState *st) {
+  const char *value = getenv("GEMM_OOC_MB");
+  size_t mb = (value != NULL && atoi(value) > 0) ? atoi(value) : OOC_DEFAULT_MB;
+  size_t rows_budget = (mb << 20) / sizeof(int32_t) / st->n;
+
+  st->kb = (st->tiles->kc < st->n) ? st->tiles->kc : st->n;
+  if ((size_t)st->kb > rows_budget / 4) {
+    st->kb = (rows_budget >= 4) ? (int)(rows_budget / 4) : 1;
+  }
+  size_t rows = (rows_budget > 2 * (size_t)st->kb)
+                    ? (rows_budget - 2 * (size_t)st->kb) / 4 : 1;
+  if (rows > (size_t)st->tiles->mc) {
+    rows -= rows % st->tiles->mc;
+  }
+  st->mb = (rows < (size_t)st->n) ? (int)rows : st->n;
+  if (st->mb < 1) {
+    st->mb = 1;
+  }
+
+  st->panels = gemm_num_blocks(st->n, st->mb);
+  st->depth = gemm_num_blocks(st->n, st->kb);
+}
+
+// Cerrar los ficheros de entrada y liberar los buffers
+static void release(OocState *st) {
+  if (st->fd_a >= 0) {
+    close(st->fd_a);
+  }
+  if (st->fd_b >= 0) {
+    close(st->fd_b);
+  }
+  for (int i = 0; i < 2; i++) {
+    free(st->a[i]);
+    free(st->b[i]);
+    free(st->c[i]);
+  }
+}
+
+int ooc_enabled(void) {
+  const char *value = getenv("GEMM_OOC");
+  return value != NULL && atoi(value) > 0;
+}
+
+int ooc_gemm(const char *a_path, const char *b_path, const char *c_path,
+             int n, const TileConfig *tiles, OocStats *stats) {
+  OocState st;
+  memset(&st, 0, sizeof(st));
+  st.n = n;
+  st.tiles = tiles;
+
+  MatFileHeader ha, hb, hc;
+  st.fd_a = matfile_open_fd(a_path, &ha);
+  st.fd_b = matfile_open_fd(b_path, &hb);
+  if (st.fd_a < 0 || st.fd_b < 0) {
+    release(&st);
+    return 0;
+  }
+  if (ha.rows != (uint64_t)n || ha.cols != (uint64_t)n ||
+      ha.layout != GEMM_B_NORMAL || hb.rows != (uint64_t)n ||
+      hb.cols != (uint64_t)n || hb.layout != GEMM_B_NORMAL) {
+    fprintf(stderr, "GEMM_OOC: se esperaban A y B %dx%d por filas\n", n, n);
+    release(&st);
+    return 0;
+  }
+  st.off_a = ha.data_offset;
+  st.off_b = hb.data_offset;
+
+  // Lectura secuencial dentro de cada panel
+  posix_fadvise(st.fd_a, 0, 0, POSIX_FADV_SEQUENTIAL);
+  posix_fadvise(st.fd_b, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  choose_panels(&st);
+  size_t panel = (size_t)st.mb * n;
+  for (int i = 0; i < 2; i++) {
+    st.a[i] = (int32_t *)malloc(panel * sizeof(int32_t));
+    st.c[i] = (int32_t *)malloc(panel * sizeof(int32_t));
+    st.b[i] = (int32_t *)malloc((size_t)st.kb * n * sizeof(int32_t));
+    if (!st.a[i] || !st.b[i] || !st.c[i]) {
+      fprintf(stderr, "GEMM_OOC: no caben los paneles (GEMM_OOC_MB)\n");
+      release(&st);
+      return 0;
+    }
+  }
+
+  // C se crea después de comprobar A y B para no truncarla en vano
+  st.fd_c = matfile_create_fd(c_path, n, n, GEMM_B_NORMAL, &hc);
+  if (st.fd_c < 0) {
+    release(&st);
+    return 0;
+  }
+  st.off_c = hc.data_offset;
+
+  matfile_checksum_init(&st.sum);
+  pthread_mutex_init(&st.lock, NULL);
+  pthread_cond_init(&st.cond, NULL);
+
+  double start = now();
+  double io_wait = 0.0;
+  pthread_t io;
+  if (pthread_create(&io, NULL, io_thread, &st) != 0) {
+    st.error = 1;
+  }
+
+  int steps = st.error ? 0 : st.panels * st.depth;
+  for (int s = 0; s < steps; s++) {
+    int ip = s / st.depth;
+    int kp = s % st.depth;
+
+    // Esperar a los paneles del paso y, al empezar un panel de C, a que se
+    // haya escrito el que ocupaba antes su buffer
+    double wait_start = now();
+    pthread_mutex_lock(&st.lock);
+    while (!st.error &&
+           (st.loaded <= s || (kp == 0 && st.written < ip - 1))) {
+      pthread_cond_wait(&st.cond, &st.lock);
+    }
+    int error = st.error;
+    pthread_mutex_unlock(&st.lock);
+    io_wait += now() - wait_start;
+    if (error) {
+      break;
+    }
+
+    int rows = panel_rows(&st, ip);
+    int32_t *C = st.c[ip % 2];
+    if (kp == 0) {
+      memset(C, 0, (size_t)rows * n * sizeof(int32_t));
+    }
+    compute_step(&st, C, st.a[ip % 2] + (size_t)kp * st.kb, st.b[s % 2],
+                 rows, panel_depth(&st, kp));
+
+    pthread_mutex_lock(&st.lock);
+    st.computed = s + 1;
+    pthread_cond_broadcast(&st.cond);
+    pthread_mutex_unlock(&st.lock);
+  }
+
+  if (steps > 0) {
+    pthread_join(io, NULL);
+  }
+  stats->seconds = now() - start;
+  stats->io_wait_seconds = io_wait;
+  stats->bytes_read = st.bytes_read;
+  stats->panel_rows = st.mb;
+  stats->panel_depth = st.kb;
+
+  int ok = !st.error;
+  if (!ok) {
+    fprintf(stderr, "GEMM_OOC: error de lectura o escritura\n");
+  }
+  // Con error C queda sin magic y no se puede abrir como válida
+  if (ok) {
+    ok = matfile_finish_fd(st.fd_c, &hc, matfile_checksum_final(&st.sum));
+  } else {
+    close(st.fd_c);
+  }
+
+  pthread_mutex_destroy(&st.lock);
+  pthread_cond_destroy(&st.cond);
+  release(&st);
+  return ok;
+}
+
+// Generar el operando en su fichero si todavía no existe
+static int prepare_operand(const char *var, int n, uint64_t seed, int id) {
+  const char *path = getenv(var);
+  if (access(path, F_OK) == 0) {
+    return 1;
+  }
+
+  MatFile mf;
+  return matfile_operand(var, n, seed, id, &mf) && matfile_close(&mf);
+}
+
+int ooc_run(int n, uint64_t seed, OocStats *stats) {
+  const char *a = getenv("GEMM_A_FILE");
+  const char *b = getenv("GEMM_B_FILE");
+  const char *c = getenv("GEMM_C_FILE");
+  if (!a || !*a || !b || !*b || !c || !*c) {
+    fprintf(stderr, "GEMM_OOC necesita GEMM_A_FILE, GEMM_B_FILE y GEMM_C_FILE\n");
+    return 0;
+  }
+
+  if (!prepare_operand("GEMM_A_FILE", n, seed, MATRIX_A) ||
+      !prepare_operand("GEMM_B_FILE", n, seed, MATRIX_B)) {
+    return 0;
+  }
+
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+  return ooc_gemm(a, b, c, n, &tiles, stats);
+}
+
+int ooc_verify(uint64_t seed) {
+  // A cero: si falla una apertura las siguientes no se intentan y
+  // matfile_close no debe ver basura
+  MatFile fa = { 0 }, fb = { 0 }, fc = { 0 };
+  int ok = matfile_open(getenv("GEMM_A_FILE"), &fa) != NULL;
+  ok = ok && matfile_open(getenv("GEMM_B_FILE"), &fb) != NULL;
+  ok = ok && matfile_open(getenv("GEMM_C_FILE"), &fc) != NULL;
+  if (ok) {
+    ok = freivalds_verify(fa.data, fb.data, GEMM_INT32, GEMM_B_NORMAL,
+                          fc.data, (int)fc.header->rows, seed);
+  }
+  matfile_close(&fa);
+  matfile_close(&fb);
+  matfile_close(&fc);
+  return ok;
+}
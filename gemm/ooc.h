@@ -0,0 +1,39 @@
+#ifndef OOC_H
+#define OOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "gemm.h"
+
+// Multiplicación fuera de núcleo (GEMM_OOC=1): A, B y C se quedan en los
+// ficheros de GEMM_A_FILE, GEMM_B_FILE y GEMM_C_FILE y solo se tienen en
+// memoria unos paneles, dentro de GEMM_OOC_MB megas (1024 por defecto)
+int ooc_enabled(void);
+
+typedef struct {
+  double seconds;         // tiempo total, E/S incluida
+  double io_wait_seconds; // tiempo que el cálculo ha esperado a la E/S
+  size_t bytes_read;
+  int panel_rows;         // filas de A y C por panel
+  int panel_depth;        // filas de B por panel
+} OocStats;
+
+// C = A * B sobre ficheros n x n por filas. Un hilo de E/S lee con pread el
+// panel siguiente de A y B (doble buffer, con posix_fadvise para adelantar
+// el siguiente) y escribe los paneles terminados de C mientras el hilo que
+// llama calcula con los ya cargados; compilado con OpenMP el cálculo de
+// cada panel se reparte entre los hilos. Devuelve 0 si falla
+int ooc_gemm(const char *a_path, const char *b_path, const char *c_path,
+             int n, const TileConfig *tiles, OocStats *stats);
+
+// Ejecutar el modo fuera de núcleo de los programas: genera A o B en su
+// fichero si aún no existe (los valores dependen solo de la semilla) y
+// llama a ooc_gemm. Devuelve 0 si falla
+int ooc_run(int n, uint64_t seed, OocStats *stats);
+
+// Comprobar con Freivalds el C que dejó ooc_run, mapeando los tres
+// ficheros (la memoria la gestiona el sistema; no hace falta que quepan).
+// Devuelve 1 si C es correcta
+int ooc_verify(uint64_t seed);
+
+#endif
@@ -0,0 +1,203 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "placement.h"
+#include "gemm.h"
+#include "rng.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define SYSFS_NODE "/sys/devices/system/node"
+
+PlacementMode placement_mode(void) {
+  const char *value = getenv("GEMM_PLACEMENT");
+  if (value == NULL || strcmp(value, "none") == 0) {
+    return PLACEMENT_NONE;
+  }
+  if (strcmp(value, "first-touch") == 0) {
+    return PLACEMENT_FIRST_TOUCH;
+  }
+  if (strcmp(value, "replicate") == 0) {
+    return PLACEMENT_REPLICATE;
+  }
+  fprintf(stderr, "GEMM_PLACEMENT=%s desconocido, se usa none\n", value);
+  return PLACEMENT_NONE;
+}
+
+const char *placement_name(PlacementMode mode) {
+  switch (mode) {
+    case PLACEMENT_FIRST_TOUCH: return "first-touch";
+    case PLACEMENT_REPLICATE: return "replicate";
+    default: return "none";
+  }
+}
+
+// Leer una lista de sysfs ("0-3,8-11") en un cpu_set_t
+static int read_list(const char *path, cpu_set_t *set) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    return 0;
+  }
+
+  CPU_ZERO(set);
+  int lo, hi, found = 0;
+  while (fscanf(f, "%d", &lo) == 1) {
+    hi = lo;
+    int c = fgetc(f);
+    if (c == '-') {
+      if (fscanf(f, "%d", &hi) != 1) {
+        break;
+      }
+      c = fgetc(f);
+    }
+    for (int i = lo; i <= hi && i < CPU_SETSIZE; i++) {
+      CPU_SET(i, set);
+      found = 1;
+    }
+    if (c != ',') {
+      break;
+    }
+  }
+
+  fclose(f);
+  return found;
+}
+
+int topology_init(Topology *t) {
+  cpu_set_t allowed, nodes, node_cpus;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return 0;
+  }
+
+  int total = CPU_COUNT(&allowed);
+  t->cpus = (int *)malloc(total * sizeof(int));
+  t->node_start = (int *)malloc((total + 1) * sizeof(int));
+  if (!t->cpus || !t->node_start) {
+    topology_free(t);
+    return 0;
+  }
+
+  t->num_nodes = 0;
+  int used = 0;
+  if (read_list(SYSFS_NODE "/online", &nodes)) {
+    for (int k = 0; k < CPU_SETSIZE && used < total; k++) {
+      char path[64];
+      snprintf(path, sizeof(path), SYSFS_NODE "/node%d/cpulist", k);
+      if (!CPU_ISSET(k, &nodes) || !read_list(path, &node_cpus)) {
+        continue;
+      }
+
+      // Solo las CPUs permitidas; un nodo sin ninguna no cuenta
+      int start = used;
+      for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, &node_cpus) && CPU_ISSET(c, &allowed) && used < total) {
+          t->cpus[used++] = c;
+        }
+      }
+      if (used > start) {
+        t->node_start[t->num_nodes++] = start;
+      }
+    }
+  }
+
+  // Sin sysfs (o CPUs fuera de todos los nodos): un único nodo
+  if (used < total) {
+    t->num_nodes = 1;
+    t->node_start[0] = 0;
+    used = 0;
+    for (int c = 0; c < CPU_SETSIZE && used < total; c++) {
+      if (CPU_ISSET(c, &allowed)) {
+        t->cpus[used++] = c;
+      }
+    }
+  }
+
+  t->node_start[t->num_nodes] = used;
+  return 1;
+}
+
+void topology_free(Topology *t) {
+  free(t->cpus);
+  free(t->node_start);
+  t->cpus = NULL;
+  t->node_start = NULL;
+  t->num_nodes = 0;
+}
+
+int topology_node(const Topology *t, int i, int num_threads) {
+  return (int)((long)i * t->num_nodes / num_threads);
+}
+
+int topology_cpu(const Topology *t, int i, int num_threads) {
+  int node = topology_node(t, i, num_threads);
+  // Primer hilo asignado a este nodo
+  int first = (int)(((long)node * num_threads + t->num_nodes - 1) / t->num_nodes);
+  int count = t->node_start[node + 1] - t->node_start[node];
+  return t->cpus[t->node_start[node] + (i - first) % count];
+}
+
+int pin_thread(int cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+void placement_bind_omp(const Topology *t, int num_threads) {
+  #pragma omp parallel num_threads(num_threads)
+  {
+    int id = 0;
+#ifdef _OPENMP
+    id = omp_get_thread_num();
+#endif
+    pin_thread(topology_cpu(t, id, num_threads));
+  }
+}
+
+void first_touch_block(int32_t *A, int32_t *C, int n, uint64_t seed,
+                       int i0, int i1, int j0, int j1) {
+  if (A != NULL) {
+    generate_block(A + (size_t)i0 * n + j0, n, seed, MATRIX_A, n,
+                   i0, i1 - i0, j0, j1 - j0, GEMM_B_NORMAL);
+  }
+  for (int i = i0; i < i1; i++) {
+    memset(C + (size_t)i * n + j0, 0, (j1 - j0) * sizeof(int32_t));
+  }
+}
+
+int32_t **replicate_per_node(const int32_t *M, size_t count, const Topology *t) {
+  int32_t **replicas = (int32_t **)calloc(t->num_nodes, sizeof(int32_t *));
+  cpu_set_t saved;
+  if (!replicas || sched_getaffinity(0, sizeof(saved), &saved) != 0) {
+    free(replicas);
+    return NULL;
+  }
+
+  for (int k = 0; k < t->num_nodes; k++) {
+    pin_thread(t->cpus[t->node_start[k]]);
+    replicas[k] = (int32_t *)malloc(count * sizeof(int32_t));
+    if (!replicas[k]) {
+      sched_setaffinity(0, sizeof(saved), &saved);
+      free_replicas(replicas, t);
+      return NULL;
+    }
+    memcpy(replicas[k], M, count * sizeof(int32_t));
+  }
+
+  sched_setaffinity(0, sizeof(saved), &saved);
+  return replicas;
+}
+
+void free_replicas(int32_t **replicas, const Topology *t) {
+  if (!replicas) {
+    return;
+  }
+  for (int k = 0; k < t->num_nodes; k++) {
+    free(replicas[k]);
+  }
+  free(replicas);
+}
@@ -0,0 +1,58 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Colocación de memoria e hilos en máquinas NUMA (variable GEMM_PLACEMENT)
+//   none        - sin cambios (por defecto)
+//   first-touch - hilos fijados a CPUs y cada hilo toca primero las filas
+//                 o bloques de A y C que va a calcular
+//   replicate   - además, una copia de B en cada nodo NUMA
+typedef enum {
+  PLACEMENT_NONE = 0,
+  PLACEMENT_FIRST_TOUCH = 1,
+  PLACEMENT_REPLICATE = 2
+} PlacementMode;
+
+// CPUs permitidas al proceso agrupadas por nodo, leídas de sysfs. Las CPUs
+// del nodo k son cpus[node_start[k] .. node_start[k + 1])
+typedef struct {
+  int num_nodes;
+  int *node_start;
+  int *cpus;
+} Topology;
+
+PlacementMode placement_mode(void);
+const char *placement_name(PlacementMode mode);
+
+// Leer /sys/devices/system/node; sin sysfs se usa un único nodo con las
+// CPUs de la afinidad del proceso. Devuelve 0 si falla
+int topology_init(Topology *t);
+void topology_free(Topology *t);
+
+// Nodo y CPU del hilo i de num_threads. Los hilos se reparten en bloques
+// contiguos entre nodos para que hilos con filas vecinas compartan nodo
+int topology_node(const Topology *t, int i, int num_threads);
+int topology_cpu(const Topology *t, int i, int num_threads);
+
+// Fijar el hilo que llama a una CPU; devuelve 0 si falla
+int pin_thread(int cpu);
+
+// Fijar cada hilo de OpenMP a su CPU (los equipos siguientes de
+// num_threads hilos reutilizan los mismos hilos)
+void placement_bind_omp(const Topology *t, int num_threads);
+
+// Generar A[i0:i1, j0:j1] y poner a cero C[i0:i1, j0:j1] desde el hilo
+// que va a calcular ese bloque, para que sus páginas queden en su nodo.
+// Con A == NULL (A ya leída de fichero) solo se toca C
+void first_touch_block(int32_t *A, int32_t *C, int n, uint64_t seed,
+                       int i0, int i1, int j0, int j1);
+
+// Una copia de M (count enteros) por nodo. El hilo que llama pasa por una
+// CPU de cada nodo para hacer allí el primer contacto y luego recupera su
+// afinidad. Devuelve NULL si falta memoria
+int32_t **replicate_per_node(const int32_t *M, size_t count, const Topology *t);
+void free_replicas(int32_t **replicas, const Topology *t);
+
+#endif
@@ -0,0 +1,343 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <immintrin.h>
+#include "rng.h"
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+// Franja de filas almacenadas que genera cada hilo de una vez
+#define GEN_BAND 64
+
+static void philox4x32(const uint32_t ctr_in[4], uint64_t seed, uint32_t out[4]) {
+  uint32_t c0 = ctr_in[0], c1 = ctr_in[1], c2 = ctr_in[2], c3 = ctr_in[3];
+  uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+
+  for (int r = 0; r < PHILOX_ROUNDS; r++) {
+    uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+    uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+    uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+    uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+    c1 = (uint32_t)p1;
+    c3 = (uint32_t)p0;
+    c0 = n0;
+    c2 = n2;
+    k0 += PHILOX_W0;
+    k1 += PHILOX_W1;
+  }
+
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+// Grupos de 4 valores que se calculan a la vez, con cada palabra del
+// contador de todos ellos en un registro SIMD
+#define PHILOX_LANES 16
+
+// Lado del bloque que se genera y se copia traspuesto con B transpuesta
+#define GEN_TILE 64
+
+// Multiplicador para dividir entre 100: x / 100 = (x * MAGIC_100) >> 37
+#define MAGIC_100 0x51EB851Fu
+
+// Philox4x32-10 de los contadores (group + l, id, stream) para l = 0 ..
+// PHILOX_LANES - 1, con el mismo resultado que philox4x32 grupo a grupo:
+// out[w][l] es la palabra w del grupo group + l, o su resto entre 100 si
+// reduce
+typedef void (*PhiloxLanesFn)(uint64_t group, uint32_t id, uint32_t stream,
+                              uint64_t seed, int reduce,
+                              uint32_t out[4][PHILOX_LANES]);
+
+static void group_counters(uint64_t group, uint32_t lo[PHILOX_LANES],
+                           uint32_t hi[PHILOX_LANES]) {
+  for (int l = 0; l < PHILOX_LANES; l++) {
+    lo[l] = (uint32_t)(group + l);
+    hi[l] = (uint32_t)((group + l) >> 32);
+  }
+}
+
+// Mitades alta y baja de a * m en cada palabra de 32 bits: pmuludq solo
+// multiplica las palabras pares, así que las impares se desplazan antes
+static inline void mulhilo_sse2(__m128i a, __m128i m, __m128i *hi,
+                                __m128i *lo) {
+  const __m128i low = _mm_set1_epi64x(0xFFFFFFFF);
+  __m128i even = _mm_mul_epu32(a, m);
+  __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), m);
+  *lo = _mm_or_si128(_mm_and_si128(even, low), _mm_slli_epi64(odd, 32));
+  *hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(low, odd));
+}
+
+// x % 100 = x - 100 * (x / 100), con 100 q = 64 q + 32 q + 4 q
+static inline __m128i mod100_sse2(__m128i x) {
+  __m128i q, lo;
+  mulhilo_sse2(x, _mm_set1_epi32((int)MAGIC_100), &q, &lo);
+  q = _mm_srli_epi32(q, 5);
+  __m128i q100 = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(q, 6),
+                                             _mm_slli_epi32(q, 5)),
+                               _mm_slli_epi32(q, 2));
+  return _mm_sub_epi32(x, q100);
+}
+
+static void philox_lanes_sse2(uint64_t group, uint32_t id, uint32_t stream,
+                              uint64_t seed, int reduce,
+                              uint32_t out[4][PHILOX_LANES]) {
+  const __m128i m0 = _mm_set1_epi32((int)PHILOX_M0);
+  const __m128i m1 = _mm_set1_epi32((int)PHILOX_M1);
+  uint32_t lo[PHILOX_LANES], hi[PHILOX_LANES];
+  group_counters(group, lo, hi);
+
+  for (int v = 0; v < PHILOX_LANES; v += 4) {
+    __m128i c0 = _mm_loadu_si128((const __m128i *)(lo + v));
+    __m128i c1 = _mm_loadu_si128((const __m128i *)(hi + v));
+    __m128i c2 = _mm_set1_epi32((int)id);
+    __m128i c3 = _mm_set1_epi32((int)stream);
+    uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+
+    for (int r = 0; r < PHILOX_ROUNDS; r++) {
+      __m128i h0, l0, h1, l1;
+      mulhilo_sse2(c0, m0, &h0, &l0);
+      mulhilo_sse2(c2, m1, &h1, &l1);
+      c0 = _mm_xor_si128(_mm_xor_si128(h1, c1), _mm_set1_epi32((int)k0));
+      c2 = _mm_xor_si128(_mm_xor_si128(h0, c3), _mm_set1_epi32((int)k1));
+      c1 = l1;
+      c3 = l0;
+      k0 += PHILOX_W0;
+      k1 += PHILOX_W1;
+    }
+
+    if (reduce) {
+      c0 = mod100_sse2(c0);
+      c1 = mod100_sse2(c1);
+      c2 = mod100_sse2(c2);
+      c3 = mod100_sse2(c3);
+    }
+    _mm_storeu_si128((__m128i *)(out[0] + v), c0);
+    _mm_storeu_si128((__m128i *)(out[1] + v), c1);
+    _mm_storeu_si128((__m128i *)(out[2] + v), c2);
+    _mm_storeu_si128((__m128i *)(out[3] + v), c3);
+  }
+}
+
+__attribute__((target("avx2")))
+static inline void mulhilo_avx2(__m256i a, __m256i m, __m256i *hi,
+                                __m256i *lo) {
+  const __m256i low = _mm256_set1_epi64x(0xFFFFFFFF);
+  __m256i even = _mm256_mul_epu32(a, m);
+  __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+  *lo = _mm256_or_si256(_mm256_and_si256(even, low),
+                        _mm256_slli_epi64(odd, 32));
+  *hi = _mm256_or_si256(_mm256_srli_epi64(even, 32),
+                        _mm256_andnot_si256(low, odd));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i mod100_avx2(__m256i x) {
+  __m256i q, lo;
+  mulhilo_avx2(x, _mm256_set1_epi32((int)MAGIC_100), &q, &lo);
+  q = _mm256_srli_epi32(q, 5);
+  __m256i q100 = _mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(q, 6),
+                                                   _mm256_slli_epi32(q, 5)),
+                                  _mm256_slli_epi32(q, 2));
+  return _mm256_sub_epi32(x, q100);
+}
+
+__attribute__((target("avx2")))
+static void philox_lanes_avx2(uint64_t group, uint32_t id, uint32_t stream,
+                              uint64_t seed, int reduce,
+                              uint32_t out[4][PHILOX_LANES]) {
+  const __m256i m0 = _mm256_set1_epi32((int)PHILOX_M0);
+  const __m256i m1 = _mm256_set1_epi32((int)PHILOX_M1);
+  uint32_t lo[PHILOX_LANES], hi[PHILOX_LANES];
+  group_counters(group, lo, hi);
+
+  for (int v = 0; v < PHILOX_LANES; v += 8) {
+    __m256i c0 = _mm256_loadu_si256((const __m256i *)(lo + v));
+    __m256i c1 = _mm256_loadu_si256((const __m256i *)(hi + v));
+    __m256i c2 = _mm256_set1_epi32((int)id);
+    __m256i c3 = _mm256_set1_epi32((int)stream);
+    uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+
+    for (int r = 0; r < PHILOX_ROUNDS; r++) {
+      __m256i h0, l0, h1, l1;
+      mulhilo_avx2(c0, m0, &h0, &l0);
+      mulhilo_avx2(c2, m1, &h1, &l1);
+      c0 = _mm256_xor_si256(_mm256_xor_si256(h1, c1),
+                            _mm256_set1_epi32((int)k0));
+      c2 = _mm256_xor_si256(_mm256_xor_si256(h0, c3),
+                            _mm256_set1_epi32((int)k1));
+      c1 = l1;
+      c3 = l0;
+      k0 += PHILOX_W0;
+      k1 += PHILOX_W1;
+    }
+
+    if (reduce) {
+      c0 = mod100_avx2(c0);
+      c1 = mod100_avx2(c1);
+      c2 = mod100_avx2(c2);
+      c3 = mod100_avx2(c3);
+    }
+    _mm256_storeu_si256((__m256i *)(out[0] + v), c0);
+    _mm256_storeu_si256((__m256i *)(out[1] + v), c1);
+    _mm256_storeu_si256((__m256i *)(out[2] + v), c2);
+    _mm256_storeu_si256((__m256i *)(out[3] + v), c3);
+  }
+}
+
+// SSE2 siempre está en x86-64; AVX2 se elige con cpuid al iniciar, como
+// el micro-kernel
+static PhiloxLanesFn philox_lanes = philox_lanes_sse2;
+
+__attribute__((constructor))
+static void select_philox_lanes(void) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    philox_lanes = philox_lanes_avx2;
+  }
+}
+
+// Umbral de 32 bits para GEMM_DENSITY; 0 si todos los elementos se
+// conservan
+static uint64_t density_threshold(void) {
+  const char *value = getenv("GEMM_DENSITY");
+  double d = (value != NULL) ? strtod(value, NULL) : 1.0;
+  return (d >= 0.0 && d < 1.0) ? (uint64_t)(d * 4294967296.0) + 1 : 0;
+}
+
+// Valores de los elementos e .. e + count - 1 (índices lineales de la
+// matriz id) en vals. Cada llamada a Philox da 4 valores, los de los
+// indices 4g .. 4g + 3; con GEMM_DENSITY un segundo flujo (ctr[3] = 1)
+// decide qué elementos se conservan. Los grupos completos se calculan de
+// PHILOX_LANES en PHILOX_LANES y los de los extremos uno a uno
+static void philox_values(uint64_t e, int count, uint64_t seed, int id,
+                          uint64_t keep, int32_t *vals) {
+  int done = 0;
+
+  while (done < count) {
+    uint64_t group = e >> 2;
+    int offset = (int)(e & 3);
+
+    if (offset == 0 && count - done >= 4 * PHILOX_LANES) {
+      uint32_t out[4][PHILOX_LANES], mask[4][PHILOX_LANES];
+      philox_lanes(group, (uint32_t)id, 0, seed, 1, out);
+      for (int l = 0; l < PHILOX_LANES; l++) {
+        for (int w = 0; w < 4; w++) {
+          vals[done + 4 * l + w] = (int32_t)out[w][l];
+        }
+      }
+      if (keep) {
+        philox_lanes(group, (uint32_t)id, 1, seed, 0, mask);
+        for (int l = 0; l < PHILOX_LANES; l++) {
+          for (int w = 0; w < 4; w++) {
+            if (mask[w][l] >= keep) {
+              vals[done + 4 * l + w] = 0;
+            }
+          }
+        }
+      }
+      done += 4 * PHILOX_LANES;
+      e += 4 * PHILOX_LANES;
+      continue;
+    }
+
+    uint32_t ctr[4] = { (uint32_t)group, (uint32_t)(group >> 32),
+                        (uint32_t)id, 0 };
+    uint32_t out[4], mask[4] = {0};
+    philox4x32(ctr, seed, out);
+    if (keep) {
+      ctr[3] = 1;
+      philox4x32(ctr, seed, mask);
+    }
+    for (int w = offset; w < 4 && done < count; w++, done++, e++) {
+      vals[done] = (keep && mask[w] >= keep) ? 0 : (int32_t)(out[w] % 100);
+    }
+  }
+}
+
+void generate_block(int32_t *M, int ld, uint64_t seed, int id, int n,
+                    int i0, int rows, int j0, int cols, GemmLayout layout) {
+  uint64_t keep = density_threshold();
+
+  if (layout != GEMM_B_TRANSPOSED) {
+    for (int r = 0; r < rows; r++) {
+      philox_values((uint64_t)(i0 + r) * n + j0, cols, seed, id, keep,
+                    M + (size_t)r * ld);
+    }
+    return;
+  }
+
+  // Con B transpuesta las filas logicas son columnas almacenadas: se genera
+  // un bloque de GEN_TILE x GEN_TILE por filas y se copia traspuesto, de
+  // modo que las escrituras en M son seguidas
+  int32_t tile[GEN_TILE][GEN_TILE];
+  for (int r0 = 0; r0 < rows; r0 += GEN_TILE) {
+    int h = (r0 + GEN_TILE < rows) ? GEN_TILE : rows - r0;
+    for (int c0 = 0; c0 < cols; c0 += GEN_TILE) {
+      int w = (c0 + GEN_TILE < cols) ? GEN_TILE : cols - c0;
+      for (int r = 0; r < h; r++) {
+        philox_values((uint64_t)(i0 + r0 + r) * n + j0 + c0, w, seed, id,
+                      keep, tile[r]);
+      }
+      for (int c = 0; c < w; c++) {
+        int32_t *dst = M + (size_t)(c0 + c) * ld + r0;
+        for (int r = 0; r < h; r++) {
+          dst[r] = tile[r][c];
+        }
+      }
+    }
+  }
+}
+
+static int parse_seed(const char *text, uint64_t *seed) {
+  char *end;
+  errno = 0;
+  unsigned long long value = strtoull(text, &end, 0);
+  if (text[0] == '\0' || text[0] == '-' || *end != '\0' || errno != 0) {
+    return 0;
+  }
+  *seed = (uint64_t)value;
+  return 1;
+}
+
+int seed_requested(int *argc, char *argv[], uint64_t *seed) {
+  int ok = 1;
+  int out = 1;
+  *seed = (uint64_t)time(NULL);
+  for (int i = 1; i < *argc; i++) {
+    if (strcmp(argv[i], "--seed") == 0) {
+      ok = (i + 1 < *argc) && parse_seed(argv[++i], seed) && ok;
+    } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+      ok = parse_seed(argv[i] + 7, seed) && ok;
+    } else {
+      argv[out++] = argv[i];
+    }
+  }
+  argv[out] = NULL;
+  *argc = out;
+  return ok;
+}
+
+void generate_matrix_philox(int32_t *M, int n, uint64_t seed, int id,
+                            GemmLayout layout) {
+  int bands = gemm_num_blocks(n, GEN_BAND);
+
+  #pragma omp parallel for schedule(static)
+  for (int b = 0; b < bands; b++) {
+    int s0 = b * GEN_BAND;
+    int w = (s0 + GEN_BAND < n) ? GEN_BAND : n - s0;
+    // Las filas almacenadas de una B transpuesta son columnas logicas
+    if (layout == GEMM_B_TRANSPOSED) {
+      generate_block(M + (size_t)s0 * n, n, seed, id, n, 0, n, s0, w, layout);
+    } else {
+      generate_block(M + (size_t)s0 * n, n, seed, id, n, s0, w, 0, n, layout);
+    }
+  }
+}
@@ -0,0 +1,35 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+#include "gemm.h"
+
+// Identificadores de matriz: cada una usa su propio flujo de Philox
+#define MATRIX_A 0
+#define MATRIX_B 1
+
+// Generador basado en contador (Philox4x32-10): el elemento (i, j) de la
+// matriz 'id' de lado n depende solo de (seed, id, i * n + j), de modo que
+// cualquier reparto entre procesos o hilos produce los mismos valores.
+// Se calculan 16 contadores a la vez con SSE2 o AVX2 (elegido con cpuid).
+// Los valores estan en [0, 100), como el rand() % 100 de las versiones
+// anteriores. Con GEMM_DENSITY=d (0 <= d < 1) cada elemento se conserva con
+// probabilidad d y los demás valen 0, para probar operandos dispersos.
+
+// Llenar el bloque logico [i0, i0 + rows) x [j0, j0 + cols) de la matriz.
+// M apunta al elemento (i0, j0); con GEMM_B_NORMAL se escribe
+// M[r * ld + c] y con GEMM_B_TRANSPOSED M[c * ld + r]
+void generate_block(int32_t *M, int ld, uint64_t seed, int id, int n,
+                    int i0, int rows, int j0, int cols, GemmLayout layout);
+
+// Quitar "--seed N" (o "--seed=N") de los argumentos, como
+// verify_requested, y dejar N en seed; sin la opción la semilla es la hora
+// actual. Devuelve 0 si N no es un entero sin signo
+int seed_requested(int *argc, char *argv[], uint64_t *seed);
+
+// Generar la matriz n x n completa. Compilado con OpenMP, cada hilo genera
+// su propia franja de filas almacenadas
+void generate_matrix_philox(int32_t *M, int n, uint64_t seed, int id,
+                            GemmLayout layout);
+
+#endif
@@ -0,0 +1,340 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sparse.h"
+#include "transpose.h"
+
+// Muestra del despachador y umbral de densidad por defecto
+#define SPARSE_SAMPLES 4096
+#define SPARSE_DEFAULT_DENSITY 0.05
+
+// Filas de C por iteración del reparto dinámico
+#define SPARSE_ROWS 16
+
+typedef enum {
+  SPARSE_MODE_AUTO,
+  SPARSE_MODE_OFF,
+  SPARSE_MODE_ON
+} SparseMode;
+
+static SparseMode sparse_mode(void) {
+  const char *value = getenv("GEMM_SPARSE");
+  if (value == NULL || strcmp(value, "auto") == 0) {
+    return SPARSE_MODE_AUTO;
+  }
+  if (strcmp(value, "0") == 0) {
+    return SPARSE_MODE_OFF;
+  }
+  if (atoi(value) > 0) {
+    return SPARSE_MODE_ON;
+  }
+  fprintf(stderr, "GEMM_SPARSE=%s desconocido, se usa auto\n", value);
+  return SPARSE_MODE_AUTO;
+}
+
+static double sparse_threshold(void) {
+  const char *value = getenv("GEMM_SPARSE_DENSITY");
+  double d = (value != NULL) ? strtod(value, NULL) : 0.0;
+  return (d > 0.0 && d <= 1.0) ? d : SPARSE_DEFAULT_DENSITY;
+}
+
+static int sparse_alloc(SparseMatrix *S, SparseFormat format, int rows,
+                        int cols, size_t nnz) {
+  int outer = (format == SPARSE_CSR) ? rows : cols;
+  S->format = format;
+  S->rows = rows;
+  S->cols = cols;
+  S->nnz = nnz;
+  S->ptr = malloc(((size_t)outer + 1) * sizeof(size_t));
+  // Al menos un elemento, para que una matriz nula no parezca un fallo
+  S->idx = malloc((nnz ? nnz : 1) * sizeof(int));
+  S->val = malloc((nnz ? nnz : 1) * sizeof(int32_t));
+  if (!S->ptr || !S->idx || !S->val) {
+    sparse_free(S);
+    return 0;
+  }
+  return 1;
+}
+
+void sparse_free(SparseMatrix *S) {
+  free(S->ptr);
+  free(S->idx);
+  free(S->val);
+  memset(S, 0, sizeof(*S));
+}
+
+// Comprimir recorriendo las filas almacenadas: cada una es una fila (CSR)
+// o una columna (CSC) de la matriz
+static int compress_stored(const int32_t *M, int ld, int outer, int inner,
+                           SparseFormat format, int rows, int cols,
+                           SparseMatrix *S) {
+  size_t *count = malloc(((size_t)outer + 1) * sizeof(size_t));
+  if (!count) {
+    return 0;
+  }
+
+  #pragma omp parallel for schedule(static)
+  for (int o = 0; o < outer; o++) {
+    const int32_t *m = M + (size_t)o * ld;
+    size_t c = 0;
+    for (int x = 0; x < inner; x++) {
+      c += (m[x] != 0);
+    }
+    count[o + 1] = c;
+  }
+
+  count[0] = 0;
+  for (int o = 0; o < outer; o++) {
+    count[o + 1] += count[o];
+  }
+
+  if (!sparse_alloc(S, format, rows, cols, count[outer])) {
+    free(count);
+    return 0;
+  }
+  memcpy(S->ptr, count, ((size_t)outer + 1) * sizeof(size_t));
+  free(count);
+
+  #pragma omp parallel for schedule(static)
+  for (int o = 0; o < outer; o++) {
+    const int32_t *m = M + (size_t)o * ld;
+    size_t p = S->ptr[o];
+    for (int x = 0; x < inner; x++) {
+      if (m[x] != 0) {
+        S->idx[p] = x;
+        S->val[p] = m[x];
+        p++;
+      }
+    }
+  }
+  return 1;
+}
+
+int sparse_from_dense(const int32_t *M, int rows, int cols, int ld,
+                      GemmLayout layout, SparseFormat format, SparseMatrix *S) {
+  memset(S, 0, sizeof(*S));
+
+  // Se comprime siempre en el formato que recorre M de forma contigua y,
+  // si se pidió el otro, se convierte después
+  SparseFormat natural = (layout == GEMM_B_TRANSPOSED) ? SPARSE_CSC : SPARSE_CSR;
+  int outer = (natural == SPARSE_CSR) ? rows : cols;
+  int inner = (natural == SPARSE_CSR) ? cols : rows;
+
+  if (natural == format) {
+    return compress_stored(M, ld, outer, inner, format, rows, cols, S);
+  }
+
+  SparseMatrix tmp;
+  if (!compress_stored(M, ld, outer, inner, natural, rows, cols, &tmp)) {
+    return 0;
+  }
+  int ok = sparse_convert(&tmp, S);
+  sparse_free(&tmp);
+  return ok;
+}
+
+int sparse_convert(const SparseMatrix *S, SparseMatrix *out) {
+  SparseFormat format = (S->format == SPARSE_CSR) ? SPARSE_CSC : SPARSE_CSR;
+  int outer = (S->format == SPARSE_CSR) ? S->rows : S->cols;
+  int inner = (S->format == SPARSE_CSR) ? S->cols : S->rows;
+
+  if (!sparse_alloc(out, format, S->rows, S->cols, S->nnz)) {
+    return 0;
+  }
+
+  // Recuento por índice interior y reparto en orden de índice exterior,
+  // que deja los índices de cada fila (o columna) nueva ordenados
+  memset(out->ptr, 0, ((size_t)inner + 1) * sizeof(size_t));
+  for (size_t p = 0; p < S->nnz; p++) {
+    out->ptr[S->idx[p] + 1]++;
+  }
+  for (int x = 0; x < inner; x++) {
+    out->ptr[x + 1] += out->ptr[x];
+  }
+
+  size_t *next = malloc(((size_t)inner + 1) * sizeof(size_t));
+  if (!next) {
+    sparse_free(out);
+    return 0;
+  }
+  memcpy(next, out->ptr, ((size_t)inner + 1) * sizeof(size_t));
+
+  for (int o = 0; o < outer; o++) {
+    for (size_t p = S->ptr[o]; p < S->ptr[o + 1]; p++) {
+      size_t q = next[S->idx[p]]++;
+      out->idx[q] = o;
+      out->val[q] = S->val[p];
+    }
+  }
+
+  free(next);
+  return 1;
+}
+
+double sparse_density(const int32_t *M, size_t count) {
+  if (count == 0) {
+    return 0.0;
+  }
+
+  size_t nonzero = 0;
+  if (count <= 4 * SPARSE_SAMPLES) {
+    for (size_t i = 0; i < count; i++) {
+      nonzero += (M[i] != 0);
+    }
+    return (double)nonzero / count;
+  }
+
+  // Muestreo estratificado: una posición por tramo, desplazada dentro del
+  // tramo con un hash para no alinearse con la estructura de filas
+  size_t stride = count / SPARSE_SAMPLES;
+  for (size_t s = 0; s < SPARSE_SAMPLES; s++) {
+    uint64_t h = (s + 1) * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 29;
+    nonzero += (M[s * stride + h % stride] != 0);
+  }
+  return (double)nonzero / SPARSE_SAMPLES;
+}
+
+int sparse_plan_create(const int32_t *A, const int32_t *Bt, int n,
+                       SparsePlan *plan) {
+  memset(plan, 0, sizeof(*plan));
+  SparseMode mode = sparse_mode();
+  if (mode == SPARSE_MODE_OFF) {
+    return 1;
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  size_t count = (size_t)n * n;
+  plan->density_a = sparse_density(A, count);
+  plan->density_b = sparse_density(Bt, count);
+
+  double threshold = sparse_threshold();
+  int sparse_a = (mode == SPARSE_MODE_ON) || plan->density_a < threshold;
+  int sparse_b = (mode == SPARSE_MODE_ON) || plan->density_b < threshold;
+
+  int ok = 1;
+  if (sparse_a && sparse_b) {
+    plan->kind = SPARSE_AB;
+    ok = sparse_from_dense(A, n, n, n, GEMM_B_NORMAL, SPARSE_CSR, &plan->a) &&
+         sparse_from_dense(Bt, n, n, n, GEMM_B_TRANSPOSED, SPARSE_CSR,
+                           &plan->b);
+  } else if (sparse_a) {
+    // El kernel recorre filas de B: se vuelve a guardar por filas
+    plan->kind = SPARSE_A;
+    plan->b_rows = malloc(count * sizeof(int32_t));
+    ok = plan->b_rows != NULL &&
+         sparse_from_dense(A, n, n, n, GEMM_B_NORMAL, SPARSE_CSR, &plan->a);
+    if (ok) {
+      transpose_parallel(Bt, n, plan->b_rows, n, n, n);
+    }
+  } else if (sparse_b) {
+    plan->kind = SPARSE_B;
+    ok = sparse_from_dense(Bt, n, n, n, GEMM_B_TRANSPOSED, SPARSE_CSC,
+                           &plan->b);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  plan->seconds = (end.tv_sec - start.tv_sec) +
+                  (end.tv_nsec - start.tv_nsec) / 1e9;
+
+  if (!ok) {
+    sparse_plan_free(plan);
+  }
+  return ok;
+}
+
+// C[i, :] = A[i, :] * B con A en CSR y B densa por filas: una suma
+// escalada de filas de B por cada no nulo de A
+static void rows_sparse_dense(const SparseMatrix *A, const int32_t *B,
+                              int32_t *C, int n, int i0, int i1) {
+  for (int i = i0; i < i1; i++) {
+    int32_t *c = C + (size_t)i * n;
+    memset(c, 0, (size_t)n * sizeof(int32_t));
+    for (size_t p = A->ptr[i]; p < A->ptr[i + 1]; p++) {
+      const int32_t *b = B + (size_t)A->idx[p] * n;
+      int32_t a = A->val[p];
+      #pragma omp simd
+      for (int j = 0; j < n; j++) {
+        c[j] += a * b[j];
+      }
+    }
+  }
+}
+
+// Con B también en CSR (Gustavson): solo se suman los no nulos de cada
+// fila de B
+static void rows_sparse_sparse(const SparseMatrix *A, const SparseMatrix *B,
+                               int32_t *C, int n, int i0, int i1) {
+  for (int i = i0; i < i1; i++) {
+    int32_t *c = C + (size_t)i * n;
+    memset(c, 0, (size_t)n * sizeof(int32_t));
+    for (size_t p = A->ptr[i]; p < A->ptr[i + 1]; p++) {
+      int k = A->idx[p];
+      int32_t a = A->val[p];
+      for (size_t q = B->ptr[k]; q < B->ptr[k + 1]; q++) {
+        c[B->idx[q]] += a * B->val[q];
+      }
+    }
+  }
+}
+
+// A densa por filas y B en CSC: cada C[i, j] es el producto de la fila i
+// de A (en caché mientras se recorre j) por los no nulos de la columna j
+static void rows_dense_sparse(const int32_t *A, const SparseMatrix *B,
+                              int32_t *C, int n, int i0, int i1) {
+  for (int i = i0; i < i1; i++) {
+    const int32_t *a = A + (size_t)i * n;
+    int32_t *c = C + (size_t)i * n;
+    for (int j = 0; j < n; j++) {
+      int32_t sum = 0;
+      for (size_t q = B->ptr[j]; q < B->ptr[j + 1]; q++) {
+        sum += a[B->idx[q]] * B->val[q];
+      }
+      c[j] = sum;
+    }
+  }
+}
+
+void sparse_multiply(const SparsePlan *plan, const int32_t *A, int32_t *C,
+                     int n) {
+  int bloques = gemm_num_blocks(n, SPARSE_ROWS);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (int b = 0; b < bloques; b++) {
+    int i0 = b * SPARSE_ROWS;
+    int i1 = (i0 + SPARSE_ROWS < n) ? i0 + SPARSE_ROWS : n;
+    switch (plan->kind) {
+      case SPARSE_A:
+        rows_sparse_dense(&plan->a, plan->b_rows, C, n, i0, i1);
+        break;
+      case SPARSE_AB:
+        rows_sparse_sparse(&plan->a, &plan->b, C, n, i0, i1);
+        break;
+      case SPARSE_B:
+        rows_dense_sparse(A, &plan->b, C, n, i0, i1);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+void sparse_plan_free(SparsePlan *plan) {
+  sparse_free(&plan->a);
+  sparse_free(&plan->b);
+  free(plan->b_rows);
+  plan->b_rows = NULL;
+  plan->kind = SPARSE_NONE;
+}
+
+const char *sparse_kind_name(SparseKind kind) {
+  switch (kind) {
+    case SPARSE_A: return "A dispersa (CSR) por B densa";
+    case SPARSE_B: return "A densa por B dispersa (CSC)";
+    case SPARSE_AB: return "A y B dispersas (CSR)";
+    default: return "densa";
+  }
+}
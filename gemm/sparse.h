@@ -0,0 +1,82 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "gemm.h"
+
+// Matriz dispersa comprimida: CSR guarda los no nulos por filas y CSC por
+// columnas. El elemento p de la fila (o columna) o está en la columna (o
+// fila) idx[p] con valor val[p], para ptr[o] <= p < ptr[o + 1], con los
+// índices crecientes
+typedef enum {
+  SPARSE_CSR,
+  SPARSE_CSC
+} SparseFormat;
+
+typedef struct {
+  SparseFormat format;
+  int rows;
+  int cols;
+  size_t nnz;
+  size_t *ptr;   // filas + 1 (CSR) o columnas + 1 (CSC) entradas
+  int *idx;
+  int32_t *val;
+} SparseMatrix;
+
+// Comprimir la matriz densa rows x cols guardada en M con distancia ld
+// (con GEMM_B_TRANSPOSED el elemento (r, c) es M[c * ld + r]). Compilado
+// con OpenMP el recuento y el relleno se reparten entre los hilos.
+// Devuelve 0 si falta memoria
+int sparse_from_dense(const int32_t *M, int rows, int cols, int ld,
+                      GemmLayout layout, SparseFormat format, SparseMatrix *S);
+
+// La misma matriz en el otro formato (CSR <-> CSC). Devuelve 0 si falta
+// memoria
+int sparse_convert(const SparseMatrix *S, SparseMatrix *out);
+
+void sparse_free(SparseMatrix *S);
+
+// Fracción de elementos no nulos, estimada con una muestra fija de
+// posiciones repartidas por toda la matriz (exacta si es pequeña)
+double sparse_density(const int32_t *M, size_t count);
+
+// Camino que elige el despachador para C = A * B
+typedef enum {
+  SPARSE_NONE,  // kernel denso
+  SPARSE_A,     // A en CSR por B densa
+  SPARSE_B,     // A densa por B en CSC
+  SPARSE_AB     // A y B en CSR
+} SparseKind;
+
+typedef struct {
+  SparseKind kind;
+  double density_a;
+  double density_b;
+  SparseMatrix a;   // con SPARSE_A y SPARSE_AB
+  SparseMatrix b;   // con SPARSE_B y SPARSE_AB
+  int32_t *b_rows;  // B densa por filas, con SPARSE_A
+  double seconds;   // muestreo y conversión
+} SparsePlan;
+
+// Despachador (GEMM_SPARSE=auto por defecto): muestrea la densidad de A y
+// de B (n x n, B traspuesta como la reciben los kernels) y comprime la que
+// quede por debajo de GEMM_SPARSE_DENSITY (0.05 por defecto). Con
+// GEMM_SPARSE=1 se comprimen las dos siempre y con GEMM_SPARSE=0 nunca.
+// Devuelve 0 si falta memoria
+int sparse_plan_create(const int32_t *A, const int32_t *Bt, int n,
+                       SparsePlan *plan);
+
+// C = A * B por el camino del plan (no vale para SPARSE_NONE). A es la
+// densa original, que solo se lee con SPARSE_B. Compilado con OpenMP las
+// filas de C se reparten entre los hilos en bloques dinámicos, porque el
+// número de no nulos por fila varía
+void sparse_multiply(const SparsePlan *plan, const int32_t *A, int32_t *C,
+                     int n);
+
+void sparse_plan_free(SparsePlan *plan);
+
+// Nombre del camino, para los mensajes de los programas
+const char *sparse_kind_name(SparseKind kind);
+
+#endif
@@ -0,0 +1,275 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gemm.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Estado compartido por toda la recursion
+typedef struct {
+  GemmLayout layout;
+  int corte;
+  int task_depth; // niveles que crean tasks; por debajo se recursa en serie
+  const TileConfig *tiles;
+} StrassenCtx;
+
+// Las sumas se hacen en aritmetica modular (uint32_t) para que el resultado
+// coincida bit a bit con el producto clasico aunque los intermedios desborden
+static void mat_add(int h, const int32_t *X, int ldx, const int32_t *Y, int ldy,
+                    int32_t *Z, int ldz) {
+  for (int i = 0; i < h; i++) {
+    for (int j = 0; j < h; j++) {
+      Z[(size_t)i * ldz + j] = (int32_t)((uint32_t)X[(size_t)i * ldx + j] +
+                                         (uint32_t)Y[(size_t)i * ldy + j]);
+    }
+  }
+}
+
+static void mat_sub(int h, const int32_t *X, int ldx, const int32_t *Y, int ldy,
+                    int32_t *Z, int ldz) {
+  for (int i = 0; i < h; i++) {
+    for (int j = 0; j < h; j++) {
+      Z[(size_t)i * ldz + j] = (int32_t)((uint32_t)X[(size_t)i * ldx + j] -
+                                         (uint32_t)Y[(size_t)i * ldy + j]);
+    }
+  }
+}
+
+// Temporales de la recursion; sin memoria no hay forma de continuar
+static int32_t *alloc_block(size_t elems) {
+  int32_t *block = calloc(elems, sizeof(int32_t));
+  if (!block) {
+    fprintf(stderr, "Error al asignar memoria en Strassen\n");
+    exit(1);
+  }
+  return block;
+}
+
+static void copy_block(int h, const int32_t *X, int ldx, int32_t *Z, int ldz) {
+  for (int i = 0; i < h; i++) {
+    memcpy(Z + (size_t)i * ldz, X + (size_t)i * ldx, (size_t)h * sizeof(int32_t));
+  }
+}
+
+// Caso base: el kernel comun trabaja sobre matrices contiguas n x n, asi que
+// las vistas con otra distancia entre filas se copian antes y despues
+static void base_case(const int32_t *A, int lda, const int32_t *B, int ldb,
+                      int32_t *C, int ldc, int n, const StrassenCtx *ctx) {
+  if (lda == n && ldb == n && ldc == n) {
+    gemm_rows(A, B, C, n, ctx->layout, 0, n, ctx->tiles);
+    return;
+  }
+
+  size_t elems = (size_t)n * n;
+  int32_t *a = alloc_block(elems);
+  int32_t *b = alloc_block(elems);
+  int32_t *c = alloc_block(elems);
+
+  copy_block(n, A, lda, a, n);
+  copy_block(n, B, ldb, b, n);
+  gemm_rows(a, b, c, n, ctx->layout, 0, n, ctx->tiles);
+  copy_block(n, c, n, C, ldc);
+
+  free(a);
+  free(b);
+  free(c);
+}
+
+// Cuadrante (r, c) de una vista de lado 2h
+#define QUAD(M, ld, h, r, c) ((M) + (size_t)(r) * (h) * (ld) + (size_t)(c) * (h))
+
+// Cuadrante (r, c) de B segun su disposicion: si B esta transpuesta,
+// B_rc es la transpuesta del cuadrante (c, r) almacenado
+static const int32_t *quad_b(const int32_t *B, int ldb, int h, int r, int c,
+                             GemmLayout layout) {
+  return (layout == GEMM_B_TRANSPOSED) ? QUAD(B, ldb, h, c, r)
+                                       : QUAD(B, ldb, h, r, c);
+}
+
+// Version en serie con dos temporales (X, Y) y los cuadrantes de C como
+// espacio de trabajo (Boyer, Dumas, Pernet y Zhou, 2009)
+static void strassen_serial(const int32_t *A, int lda, const int32_t *B,
+                            int ldb, int32_t *C, int ldc, int n,
+                            const StrassenCtx *ctx) {
+  if (n <= ctx->corte) {
+    base_case(A, lda, B, ldb, C, ldc, n, ctx);
+    return;
+  }
+
+  int h = n / 2;
+  const int32_t *A11 = QUAD(A, lda, h, 0, 0), *A12 = QUAD(A, lda, h, 0, 1);
+  const int32_t *A21 = QUAD(A, lda, h, 1, 0), *A22 = QUAD(A, lda, h, 1, 1);
+  const int32_t *B11 = quad_b(B, ldb, h, 0, 0, ctx->layout);
+  const int32_t *B12 = quad_b(B, ldb, h, 0, 1, ctx->layout);
+  const int32_t *B21 = quad_b(B, ldb, h, 1, 0, ctx->layout);
+  const int32_t *B22 = quad_b(B, ldb, h, 1, 1, ctx->layout);
+  int32_t *C11 = QUAD(C, ldc, h, 0, 0), *C12 = QUAD(C, ldc, h, 0, 1);
+  int32_t *C21 = QUAD(C, ldc, h, 1, 0), *C22 = QUAD(C, ldc, h, 1, 1);
+
+  int32_t *X = alloc_block((size_t)h * h);
+  int32_t *Y = alloc_block((size_t)h * h);
+
+  mat_sub(h, A11, lda, A21, lda, X, h);            // S3
+  mat_sub(h, B22, ldb, B12, ldb, Y, h);            // T3
+  strassen_serial(X, h, Y, h, C21, ldc, h, ctx);   // P7
+  mat_add(h, A21, lda, A22, lda, X, h);            // S1
+  mat_sub(h, B12, ldb, B11, ldb, Y, h);            // T1
+  strassen_serial(X, h, Y, h, C22, ldc, h, ctx);   // P5
+  mat_sub(h, X, h, A11, lda, X, h);                // S2
+  mat_sub(h, B22, ldb, Y, h, Y, h);                // T2
+  strassen_serial(X, h, Y, h, C12, ldc, h, ctx);   // P6
+  mat_sub(h, A12, lda, X, h, X, h);                // S4
+  strassen_serial(X, h, B22, ldb, C11, ldc, h, ctx); // P3
+  strassen_serial(A11, lda, B11, ldb, X, h, h, ctx); // P1
+  mat_add(h, X, h, C12, ldc, C12, ldc);            // U2 = P1 + P6
+  mat_add(h, C12, ldc, C21, ldc, C21, ldc);        // U3 = U2 + P7
+  mat_add(h, C12, ldc, C22, ldc, C12, ldc);        // U4 = U2 + P5
+  mat_add(h, C21, ldc, C22, ldc, C22, ldc);        // U7 = U3 + P5
+  mat_add(h, C12, ldc, C11, ldc, C12, ldc);        // U5 = U4 + P3
+  mat_sub(h, Y, h, B21, ldb, Y, h);                // T4
+  strassen_serial(A22, lda, Y, h, C11, ldc, h, ctx); // P4
+  mat_sub(h, C21, ldc, C11, ldc, C21, ldc);        // U6 = U3 - P4
+  strassen_serial(A12, lda, B21, ldb, C11, ldc, h, ctx); // P2
+  mat_add(h, X, h, C11, ldc, C11, ldc);            // U1 = P1 + P2
+
+  free(X);
+  free(Y);
+}
+
+static void strassen_tasks(const int32_t *A, int lda, const int32_t *B,
+                           int ldb, int32_t *C, int ldc, int n, int depth,
+                           const StrassenCtx *ctx);
+
+static void strassen_product(const int32_t *A, int lda, const int32_t *B,
+                             int ldb, int32_t *C, int ldc, int n, int depth,
+                             const StrassenCtx *ctx) {
+  if (depth < ctx->task_depth) {
+    strassen_tasks(A, lda, B, ldb, C, ldc, n, depth, ctx);
+  } else {
+    strassen_serial(A, lda, B, ldb, C, ldc, n, ctx);
+  }
+}
+
+// Version con tasks: sumas y productos forman un grafo con depend, los 7
+// productos se ejecutan en paralelo y cada uno puede volver a dividirse
+static void strassen_tasks(const int32_t *A, int lda, const int32_t *B,
+                           int ldb, int32_t *C, int ldc, int n, int depth,
+                           const StrassenCtx *ctx) {
+  if (n <= ctx->corte) {
+    base_case(A, lda, B, ldb, C, ldc, n, ctx);
+    return;
+  }
+
+  int h = n / 2;
+  const int32_t *A11 = QUAD(A, lda, h, 0, 0), *A12 = QUAD(A, lda, h, 0, 1);
+  const int32_t *A21 = QUAD(A, lda, h, 1, 0), *A22 = QUAD(A, lda, h, 1, 1);
+  const int32_t *B11 = quad_b(B, ldb, h, 0, 0, ctx->layout);
+  const int32_t *B12 = quad_b(B, ldb, h, 0, 1, ctx->layout);
+  const int32_t *B21 = quad_b(B, ldb, h, 1, 0, ctx->layout);
+  const int32_t *B22 = quad_b(B, ldb, h, 1, 1, ctx->layout);
+  int32_t *C11 = QUAD(C, ldc, h, 0, 0), *C12 = QUAD(C, ldc, h, 0, 1);
+  int32_t *C21 = QUAD(C, ldc, h, 1, 0), *C22 = QUAD(C, ldc, h, 1, 1);
+
+  size_t hh = (size_t)h * h;
+  int32_t *tmp = alloc_block(15 * hh);
+  int32_t *S1 = tmp, *S2 = tmp + hh, *S3 = tmp + 2 * hh, *S4 = tmp + 3 * hh;
+  int32_t *T1 = tmp + 4 * hh, *T2 = tmp + 5 * hh, *T3 = tmp + 6 * hh;
+  int32_t *T4 = tmp + 7 * hh;
+  int32_t *P1 = tmp + 8 * hh, *P2 = tmp + 9 * hh, *P3 = tmp + 10 * hh;
+  int32_t *P4 = tmp + 11 * hh, *P5 = tmp + 12 * hh, *P6 = tmp + 13 * hh;
+  int32_t *P7 = tmp + 14 * hh;
+  int d = depth + 1;
+
+  #pragma omp task depend(out: S1[0])
+  mat_add(h, A21, lda, A22, lda, S1, h);
+  #pragma omp task depend(in: S1[0]) depend(out: S2[0])
+  mat_sub(h, S1, h, A11, lda, S2, h);
+  #pragma omp task depend(out: S3[0])
+  mat_sub(h, A11, lda, A21, lda, S3, h);
+  #pragma omp task depend(in: S2[0]) depend(out: S4[0])
+  mat_sub(h, A12, lda, S2, h, S4, h);
+
+  #pragma omp task depend(out: T1[0])
+  mat_sub(h, B12, ldb, B11, ldb, T1, h);
+  #pragma omp task depend(in: T1[0]) depend(out: T2[0])
+  mat_sub(h, B22, ldb, T1, h, T2, h);
+  #pragma omp task depend(out: T3[0])
+  mat_sub(h, B22, ldb, B12, ldb, T3, h);
+  #pragma omp task depend(in: T2[0]) depend(out: T4[0])
+  mat_sub(h, T2, h, B21, ldb, T4, h);
+
+  #pragma omp task depend(out: P1[0])
+  strassen_product(A11, lda, B11, ldb, P1, h, h, d, ctx);
+  #pragma omp task depend(out: P2[0])
+  strassen_product(A12, lda, B21, ldb, P2, h, h, d, ctx);
+  #pragma omp task depend(in: S4[0]) depend(out: P3[0])
+  strassen_product(S4, h, B22, ldb, P3, h, h, d, ctx);
+  #pragma omp task depend(in: T4[0]) depend(out: P4[0])
+  strassen_product(A22, lda, T4, h, P4, h, h, d, ctx);
+  #pragma omp task depend(in: S1[0], T1[0]) depend(out: P5[0])
+  strassen_product(S1, h, T1, h, P5, h, h, d, ctx);
+  #pragma omp task depend(in: S2[0], T2[0]) depend(out: P6[0])
+  strassen_product(S2, h, T2, h, P6, h, h, d, ctx);
+  #pragma omp task depend(in: S3[0], T3[0]) depend(out: P7[0])
+  strassen_product(S3, h, T3, h, P7, h, h, d, ctx);
+
+  #pragma omp task depend(in: P1[0], P2[0])
+  mat_add(h, P1, h, P2, h, C11, ldc);              // U1
+  #pragma omp task depend(in: P1[0]) depend(inout: P6[0])
+  mat_add(h, P1, h, P6, h, P6, h);                 // U2
+  #pragma omp task depend(in: P6[0]) depend(inout: P7[0])
+  mat_add(h, P6, h, P7, h, P7, h);                 // U3
+  #pragma omp task depend(in: P5[0]) depend(inout: P6[0])
+  mat_add(h, P6, h, P5, h, P6, h);                 // U4
+  #pragma omp task depend(in: P6[0], P3[0])
+  mat_add(h, P6, h, P3, h, C12, ldc);              // U5
+  #pragma omp task depend(in: P7[0], P4[0])
+  mat_sub(h, P7, h, P4, h, C21, ldc);              // U6
+  #pragma omp task depend(in: P7[0], P5[0])
+  mat_add(h, P7, h, P5, h, C22, ldc);              // U7
+
+  #pragma omp taskwait
+  free(tmp);
+}
+
+void gemm_strassen(const int32_t *A, const int32_t *B, int32_t *C, int n,
+                   GemmLayout layout, int corte, const TileConfig *tiles) {
+  StrassenCtx ctx = { layout, corte > 0 ? corte : 1, 0, tiles };
+
+  // Crear tasks solo en los niveles necesarios para ocupar el equipo:
+  // cada nivel multiplica por 7 el paralelismo y por 7/4 la memoria
+#ifdef _OPENMP
+  for (int p = 1; p < omp_get_num_threads(); p *= 7) {
+    ctx.task_depth++;
+  }
+#endif
+
+  // Lado m = c * 2^d >= n con c <= corte, para que todas las divisiones
+  // sean exactas; si m > n se rellena con ceros
+  int d = 0;
+  while (gemm_num_blocks(n, 1 << d) > ctx.corte) {
+    d++;
+  }
+  int m = gemm_num_blocks(n, 1 << d) << d;
+
+  if (m == n) {
+    strassen_product(A, n, B, n, C, n, n, 0, &ctx);
+    return;
+  }
+
+  size_t elems = (size_t)m * m;
+  int32_t *a = alloc_block(elems);
+  int32_t *b = alloc_block(elems);
+  int32_t *c = alloc_block(elems);
+
+  copy_block(n, A, n, a, m);
+  copy_block(n, B, n, b, m);
+  strassen_product(a, m, b, m, c, m, m, 0, &ctx);
+  copy_block(n, c, m, C, n);
+
+  free(a);
+  free(b);
+  free(c);
+}
@@ -0,0 +1,83 @@
+#include <stdlib.h>
+#include <time.h>
+#include "transpose.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Bloque hoja: 32 x 32 enteros de origen y destino caben juntos en L1
+#define TRANSPOSE_LEAF 32
+
+static void transpose_leaf(const int32_t *src, int lds, int32_t *dst, int ldd,
+                           int rows, int cols) {
+  for (int r = 0; r < rows; r++) {
+    for (int c = 0; c < cols; c++) {
+      dst[(size_t)c * ldd + r] = src[(size_t)r * lds + c];
+    }
+  }
+}
+
+// Por debajo de 'task_depth' niveles la recursión sigue en serie
+static void transpose_rec(const int32_t *src, int lds, int32_t *dst, int ldd,
+                          int rows, int cols, int depth, int task_depth) {
+  if (rows <= TRANSPOSE_LEAF && cols <= TRANSPOSE_LEAF) {
+    transpose_leaf(src, lds, dst, ldd, rows, cols);
+    return;
+  }
+
+  if (rows >= cols) {
+    int h = rows / 2;
+    #pragma omp task if(depth < task_depth)
+    transpose_rec(src, lds, dst, ldd, h, cols, depth + 1, task_depth);
+    transpose_rec(src + (size_t)h * lds, lds, dst + h, ldd, rows - h, cols,
+                  depth + 1, task_depth);
+  } else {
+    int h = cols / 2;
+    #pragma omp task if(depth < task_depth)
+    transpose_rec(src, lds, dst, ldd, rows, h, depth + 1, task_depth);
+    transpose_rec(src + h, lds, dst + (size_t)h * ldd, ldd, rows, cols - h,
+                  depth + 1, task_depth);
+  }
+  #pragma omp taskwait
+}
+
+void transpose_rect(const int32_t *src, int lds, int32_t *dst, int ldd,
+                    int rows, int cols) {
+  transpose_rec(src, lds, dst, ldd, rows, cols, 0, 0);
+}
+
+void transpose_parallel(const int32_t *src, int lds, int32_t *dst, int ldd,
+                        int rows, int cols) {
+#ifdef _OPENMP
+  if (!omp_in_parallel()) {
+    #pragma omp parallel
+    #pragma omp single
+    {
+      // Unas 8 tasks por hilo en las hojas de los niveles con tasks
+      int task_depth = 3;
+      for (int p = 1; p < omp_get_num_threads(); p *= 2) {
+        task_depth++;
+      }
+      transpose_rec(src, lds, dst, ldd, rows, cols, 0, task_depth);
+    }
+    return;
+  }
+#endif
+  transpose_rect(src, lds, dst, ldd, rows, cols);
+}
+
+int32_t *transpose_stage(const int32_t *B, int n, double *seconds) {
+  int32_t *Bt = (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+  if (!Bt) {
+    return NULL;
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  transpose_parallel(B, n, Bt, n, n, n);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  *seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  return Bt;
+}
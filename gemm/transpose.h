@@ -0,0 +1,22 @@
+#ifndef TRANSPOSE_H
+#define TRANSPOSE_H
+
+#include <stdint.h>
+
+// dst[c * ldd + r] = src[r * lds + c] para r < rows, c < cols.
+// Cache-oblivious: parte por la mitad la dimensión mayor hasta bloques que
+// caben en L1, sin depender del tamaño de la caché
+void transpose_rect(const int32_t *src, int lds, int32_t *dst, int ldd,
+                    int rows, int cols);
+
+// Igual, pero compilado con OpenMP reparte las mitades de los primeros
+// niveles en tasks. Llamada desde fuera de una región paralela abre la suya;
+// desde dentro (p. ej. por cada hilo) se ejecuta en serie
+void transpose_parallel(const int32_t *src, int lds, int32_t *dst, int ldd,
+                        int rows, int cols);
+
+// Etapa de transposición previa a la multiplicación: devuelve B^T (n x n)
+// en memoria nueva y su tiempo en *seconds; NULL si falta memoria
+int32_t *transpose_stage(const int32_t *B, int n, double *seconds);
+
+#endif
@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "tune.h"
+
+#define TUNE_LINE 256
+
+// Entrada cargada por tune_select
+static TuneEntry active;
+static int active_loaded = 0;
+
+const char *tune_schedule_name(TuneSchedule schedule) {
+  switch (schedule) {
+    case TUNE_SCHED_DYNAMIC: return "dynamic";
+    case TUNE_SCHED_GUIDED: return "guided";
+    default: return "static";
+  }
+}
+
+int tune_schedule_parse(const char *name, TuneSchedule *schedule) {
+  if (strcmp(name, "static") == 0) {
+    *schedule = TUNE_SCHED_STATIC;
+  } else if (strcmp(name, "dynamic") == 0) {
+    *schedule = TUNE_SCHED_DYNAMIC;
+  } else if (strcmp(name, "guided") == 0) {
+    *schedule = TUNE_SCHED_GUIDED;
+  } else {
+    return 0;
+  }
+  return 1;
+}
+
+int tune_profile_path(char *path, size_t size) {
+  const char *value = getenv("GEMM_PROFILE");
+  int len;
+
+  if (value != NULL && value[0] != '\0') {
+    if (strcmp(value, "none") == 0) {
+      return 0;
+    }
+    len = snprintf(path, size, "%s", value);
+  } else {
+    char host[128];
+    const char *home = getenv("HOME");
+    if (gethostname(host, sizeof(host)) != 0) {
+      strcpy(host, "localhost");
+    }
+    host[sizeof(host) - 1] = '\0';
+    len = snprintf(path, size, "%s/.gemm/%s.perfil",
+                   (home != NULL && home[0] != '\0') ? home : ".", host);
+  }
+  return len > 0 && (size_t)len < size;
+}
+
+// Una línea "n=... mc=... nc=... kc=... orden=... schedule=... hilos=...
+// gops=..."; las que no encajan (comentarios, líneas a medias) se ignoran
+static int parse_entry(const char *line, TuneEntry *e) {
+  char order[16], schedule[16];
+  if (sscanf(line, "n=%d mc=%d nc=%d kc=%d orden=%15s schedule=%15s "
+             "hilos=%d gops=%lf", &e->n, &e->tiles.mc, &e->tiles.nc,
+             &e->tiles.kc, order, schedule, &e->threads, &e->gops) != 8) {
+    return 0;
+  }
+  return e->n > 0 && e->tiles.mc > 0 && e->tiles.nc > 0 && e->tiles.kc > 0 &&
+         e->threads > 0 && gemm_order_parse(order, &e->tiles.order) &&
+         tune_schedule_parse(schedule, &e->schedule);
+}
+
+static void format_entry(const TuneEntry *e, char *line, size_t size) {
+  snprintf(line, size, "n=%d mc=%d nc=%d kc=%d orden=%s schedule=%s "
+           "hilos=%d gops=%.3f\n", e->n, e->tiles.mc, e->tiles.nc,
+           e->tiles.kc, gemm_order_name(e->tiles.order),
+           tune_schedule_name(e->schedule), e->threads, e->gops);
+}
+
+int tune_load(const char *path, int n, TuneEntry *entry) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    return 0;
+  }
+
+  char line[TUNE_LINE];
+  double best = INFINITY;
+  TuneEntry e;
+  while (fgets(line, sizeof(line), f)) {
+    if (!parse_entry(line, &e)) {
+      continue;
+    }
+    double distance = fabs(log((double)e.n / n));
+    if (distance < best) {
+      best = distance;
+      *entry = e;
+    }
+  }
+
+  fclose(f);
+  return best != INFINITY;
+}
+
+// Crear el directorio que contiene path (un solo nivel)
+static int make_parent(const char *path) {
+  char dir[4096];
+  const char *slash = strrchr(path, '/');
+  if (slash == NULL || slash == path) {
+    return 1;
+  }
+  size_t len = (size_t)(slash - path);
+  if (len >= sizeof(dir)) {
+    return 0;
+  }
+  memcpy(dir, path, len);
+  dir[len] = '\0';
+  return mkdir(dir, 0755) == 0 || errno == EEXIST;
+}
+
+int tune_save(const char *path, const TuneEntry *entry) {
+  char tmp[4096];
+  if (!make_parent(path)) {
+    return 0;
+  }
+  int len = snprintf(tmp, sizeof(tmp), "%s.%ld", path, (long)getpid());
+  if (len < 0 || (size_t)len >= sizeof(tmp)) {
+    return 0;
+  }
+
+  FILE *out = fopen(tmp, "w");
+  if (!out) {
+    return 0;
+  }
+
+  // Copiar las entradas de otros tamaños y añadir la nueva al final; el
+  // fichero se sustituye de una vez con rename
+  char line[TUNE_LINE];
+  FILE *in = fopen(path, "r");
+  if (in) {
+    TuneEntry e;
+    while (fgets(line, sizeof(line), in)) {
+      if (parse_entry(line, &e) && e.n == entry->n) {
+        continue;
+      }
+      fputs(line, out);
+    }
+    fclose(in);
+  } else {
+    fprintf(out, "# Perfil de ajuste de GEMM (matrix-mult-autotune)\n");
+  }
+
+  format_entry(entry, line, sizeof(line));
+  fputs(line, out);
+
+  if (fclose(out) != 0 || rename(tmp, path) != 0) {
+    unlink(tmp);
+    return 0;
+  }
+  return 1;
+}
+
+int tune_select(int n, int verbose) {
+  char path[4096];
+  TuneEntry e;
+
+  if (!tune_profile_path(path, sizeof(path)) || !tune_load(path, n, &e)) {
+    return 0;
+  }
+
+  active = e;
+  active_loaded = 1;
+  gemm_tiles_set_base(&e.tiles);
+
+  if (verbose) {
+    printf("Perfil de ajuste %s (n=%d): mc=%d nc=%d kc=%d orden=%s "
+           "schedule=%s hilos=%d\n", path, e.n, e.tiles.mc, e.tiles.nc,
+           e.tiles.kc, gemm_order_name(e.tiles.order),
+           tune_schedule_name(e.schedule), e.threads);
+  }
+  return 1;
+}
+
+TuneSchedule tune_schedule(TuneSchedule fallback) {
+  return active_loaded ? active.schedule : fallback;
+}
+
+int tune_threads(int requested, int fallback) {
+  if (requested > 0) {
+    return requested;
+  }
+  return active_loaded ? active.threads : fallback;
+}
@@ -0,0 +1,74 @@
+#ifndef TUNE_H
+#define TUNE_H
+
+#include <stddef.h>
+#include "gemm.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Perfil de ajuste por máquina: matrix-mult-autotune mide empíricamente
+// los tamaños de bloque, el orden de los bucles, la planificación de
+// OpenMP y el número de hilos para un n dado, y guarda la mejor
+// combinación en un fichero de texto por host (una línea por n). Los
+// programas lo cargan al arrancar con tune_select y usan la entrada del n
+// más parecido. El fichero es GEMM_PROFILE o, por defecto,
+// $HOME/.gemm/<host>.perfil; GEMM_PROFILE=none no carga ninguno
+
+// Planificación del reparto de bloques de filas entre hilos
+typedef enum {
+  TUNE_SCHED_STATIC = 0,
+  TUNE_SCHED_DYNAMIC = 1,
+  TUNE_SCHED_GUIDED = 2
+} TuneSchedule;
+
+typedef struct {
+  int n;                 // tamaño con el que se midió
+  TileConfig tiles;      // bloques y orden de los bucles
+  TuneSchedule schedule;
+  int threads;
+  double gops;           // rendimiento medido (2 n^3 operaciones)
+} TuneEntry;
+
+// Ruta del perfil de esta máquina en path. Devuelve 0 si no hay perfil
+// (GEMM_PROFILE=none) o la ruta no cabe
+int tune_profile_path(char *path, size_t size);
+
+// Entrada del perfil con el n más cercano (en escala logarítmica).
+// Devuelve 0 si el fichero no existe o no tiene entradas válidas
+int tune_load(const char *path, int n, TuneEntry *entry);
+
+// Añadir la entrada al perfil, sustituyendo la que tenga el mismo n, y
+// crear el directorio si hace falta. Devuelve 0 si falla
+int tune_save(const char *path, const TuneEntry *entry);
+
+// Cargar el perfil para el tamaño n y activar sus bloques como valores por
+// defecto de gemm_tiles_init (las variables GEMM_MC, etc. siguen mandando).
+// Con verbose se informa de la entrada usada. Devuelve 1 si había perfil
+int tune_select(int n, int verbose);
+
+// Planificación del perfil activo, o fallback si no hay perfil
+TuneSchedule tune_schedule(TuneSchedule fallback);
+
+// Hilos: requested si es positivo; si no, los del perfil activo o, sin
+// perfil, fallback
+int tune_threads(int requested, int fallback);
+
+const char *tune_schedule_name(TuneSchedule schedule);
+
+// "static", "dynamic" o "guided"; devuelve 0 si el nombre no es válido
+int tune_schedule_parse(const char *name, TuneSchedule *schedule);
+
+#ifdef _OPENMP
+// Fijar la planificación de los bucles schedule(runtime)
+static inline void tune_set_omp_schedule(TuneSchedule schedule) {
+  switch (schedule) {
+    case TUNE_SCHED_DYNAMIC: omp_set_schedule(omp_sched_dynamic, 0); break;
+    case TUNE_SCHED_GUIDED: omp_set_schedule(omp_sched_guided, 0); break;
+    default: omp_set_schedule(omp_sched_static, 0); break;
+  }
+}
+#endif
+
+#endif
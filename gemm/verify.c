@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "verify.h"
+#include "rng.h"
+
+#define VERIFY_DEFAULT_ROUNDS 8
+
+// Columnas de B traspuesta que acumula cada hilo de una vez
+#define VERIFY_SLAB 256
+
+int verify_requested(int *argc, char *argv[]) {
+  int found = 0;
+  int out = 1;
+  for (int i = 1; i < *argc; i++) {
+    if (strcmp(argv[i], "--verify") == 0) {
+      found = 1;
+    } else {
+      argv[out++] = argv[i];
+    }
+  }
+  argv[out] = NULL;
+  *argc = out;
+  return found;
+}
+
+int verify_rounds(void) {
+  const char *value = getenv("GEMM_VERIFY_ROUNDS");
+  return (value != NULL && atoi(value) > 0) ? atoi(value) : VERIFY_DEFAULT_ROUNDS;
+}
+
+// splitmix64 sobre el contador: cada posición es independiente
+static uint32_t mix(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return (uint32_t)(x ^ (x >> 31));
+}
+
+void freivalds_vectors(uint32_t *R, int n, int k, uint64_t seed) {
+  uint64_t base = mix(seed) | ((uint64_t)mix(~seed) << 32);
+  size_t count = (size_t)n * k;
+
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < count; i++) {
+    R[i] = mix(base + i);
+  }
+}
+
+// Copiar count elementos de tipo elem desde la posición off, ensanchados
+static void widen(const void *M, GemmElem elem, size_t off, int count,
+                  uint32_t *dst) {
+  switch (elem) {
+    case GEMM_INT8:
+      for (int i = 0; i < count; i++) {
+        dst[i] = (uint32_t)((const int8_t *)M)[off + i];
+      }
+      break;
+    case GEMM_INT16:
+      for (int i = 0; i < count; i++) {
+        dst[i] = (uint32_t)((const int16_t *)M)[off + i];
+      }
+      break;
+    default:
+      memcpy(dst, (const int32_t *)M + off, (size_t)count * sizeof(uint32_t));
+      break;
+  }
+}
+
+// out[t] += sum_c row[c] * R[c * k + t]
+static void accumulate(const uint32_t *row, int cols, const uint32_t *R, int k,
+                       uint32_t *out) {
+  for (int c = 0; c < cols; c++) {
+    uint32_t m = row[c];
+    const uint32_t *r = R + (size_t)c * k;
+    for (int t = 0; t < k; t++) {
+      out[t] += m * r[t];
+    }
+  }
+}
+
+// out[t] = sum_c M[off + c] * R[c * k + t] para una fila de cols elementos
+// de tipo elem. Se ensancha por tramos en la pila: ninguna de estas
+// funciones reserva memoria, así que valen en cualquier hilo o proceso
+static void row_times(const void *M, GemmElem elem, size_t off, int cols,
+                      const uint32_t *R, int k, uint32_t *out) {
+  uint32_t row[VERIFY_SLAB];
+  memset(out, 0, (size_t)k * sizeof(uint32_t));
+  for (int c0 = 0; c0 < cols; c0 += VERIFY_SLAB) {
+    int w = (c0 + VERIFY_SLAB < cols) ? VERIFY_SLAB : cols - c0;
+    widen(M, elem, off + c0, w, row);
+    accumulate(row, w, R + (size_t)c0 * k, k, out);
+  }
+}
+
+// Igual para la fila i de la matriz 'id' de lado n del generador
+static void generated_row_times(int id, uint64_t seed, int n, int i,
+                                const uint32_t *R, int k, uint32_t *out) {
+  int32_t row[VERIFY_SLAB];
+  memset(out, 0, (size_t)k * sizeof(uint32_t));
+  for (int c0 = 0; c0 < n; c0 += VERIFY_SLAB) {
+    int w = (c0 + VERIFY_SLAB < n) ? VERIFY_SLAB : n - c0;
+    generate_block(row, VERIFY_SLAB, seed, id, n, i, 1, c0, w, GEMM_B_NORMAL);
+    accumulate((const uint32_t *)row, w, R + (size_t)c0 * k, k, out);
+  }
+}
+
+void freivalds_apply(const void *M, GemmElem elem, int ld, int rows, int cols,
+                     const uint32_t *R, int k, uint32_t *out) {
+  #pragma omp parallel for schedule(static)
+  for (int r = 0; r < rows; r++) {
+    row_times(M, elem, (size_t)r * ld, cols, R, k, out + (size_t)r * k);
+  }
+}
+
+void freivalds_apply_generated(int id, uint64_t seed, int n, int i0, int rows,
+                               const uint32_t *R, int k, uint32_t *out) {
+  #pragma omp parallel for schedule(static)
+  for (int r = 0; r < rows; r++) {
+    generated_row_times(id, seed, n, i0 + r, R, k, out + (size_t)r * k);
+  }
+}
+
+// Filas [r0, r1) de y = B * R con B guardada traspuesta (Bt[j * n + i] =
+// B[i][j]): por tramos de VERIFY_SLAB filas de y, recorriendo todas las
+// filas de Bt
+static void transposed_rows(const FreivaldsStep *s, int r0, int r1) {
+  uint32_t row[VERIFY_SLAB];
+  int n = s->n;
+  int k = s->k;
+
+  for (int i0 = r0; i0 < r1; i0 += VERIFY_SLAB) {
+    int w = (i0 + VERIFY_SLAB < r1) ? VERIFY_SLAB : r1 - i0;
+    uint32_t *ys = s->out + (size_t)i0 * k;
+    memset(ys, 0, (size_t)w * k * sizeof(uint32_t));
+    for (int j = 0; j < n; j++) {
+      widen(s->M, s->elem, (size_t)j * n + i0, w, row);
+      const uint32_t *r = s->R + (size_t)j * k;
+      for (int i = 0; i < w; i++) {
+        for (int t = 0; t < k; t++) {
+          ys[(size_t)i * k + t] += row[i] * r[t];
+        }
+      }
+    }
+  }
+}
+
+void freivalds_step_rows(const FreivaldsStep *s, int r0, int r1) {
+  if (s->transposed) {
+    transposed_rows(s, r0, r1);
+    return;
+  }
+  for (int r = r0; r < r1; r++) {
+    row_times(s->M, s->elem, (size_t)r * s->n, s->n, s->R, s->k,
+              s->out + (size_t)r * s->k);
+  }
+}
+
+// Reparto por defecto: franjas entre los hilos de OpenMP (con la B
+// traspuesta, de VERIFY_SLAB filas para que cada fila de Bt se lea a tramos)
+static int run_openmp(void *arg, const FreivaldsStep *s) {
+  int band = s->transposed ? VERIFY_SLAB : 1;
+  int bands = gemm_num_blocks(s->n, band);
+  (void)arg;
+
+  #pragma omp parallel for schedule(static)
+  for (int b = 0; b < bands; b++) {
+    int r0 = b * band;
+    int r1 = (r0 + band < s->n) ? r0 + band : s->n;
+    freivalds_step_rows(s, r0, r1);
+  }
+  return 1;
+}
+
+int freivalds_verify(const void *A, const void *B, GemmElem elem,
+                     GemmLayout layout, const int32_t *C, int n, uint64_t seed) {
+  return freivalds_verify_with(A, B, elem, layout, C, n, seed, NULL);
+}
+
+int freivalds_verify_with(const void *A, const void *B, GemmElem elem,
+                          GemmLayout layout, const int32_t *C, int n,
+                          uint64_t seed, const FreivaldsRunner *runner) {
+  FreivaldsRunner openmp = { run_openmp, NULL, NULL };
+  if (runner == NULL) {
+    runner = &openmp;
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  int k = verify_rounds();
+  size_t count = (size_t)n * k;
+  uint32_t *vectors = runner->vectors ? runner->vectors
+                                      : malloc(4 * count * sizeof(uint32_t));
+  if (!vectors) {
+    printf("Error al asignar memoria para la verificacion\n");
+    return 0;
+  }
+  uint32_t *R = vectors;
+  uint32_t *y = R + count;
+  uint32_t *z = y + count;
+  uint32_t *w = z + count;
+
+  // y = B * R, z = A * y y w = C * R
+  FreivaldsStep steps[3] = {
+    { B, elem, layout == GEMM_B_TRANSPOSED, n, R, k, y },
+    { A, elem, 0, n, y, k, z },
+    { C, GEMM_INT32, 0, n, R, k, w },
+  };
+  freivalds_vectors(R, n, k, seed);
+  int ok = 1;
+  for (int i = 0; i < 3 && ok; i++) {
+    ok = runner->run(runner->arg, &steps[i]);
+  }
+
+  int wrong = 0;
+  for (int i = 0; i < n && ok; i++) {
+    wrong += memcmp(z + (size_t)i * k, w + (size_t)i * k,
+                    (size_t)k * sizeof(uint32_t)) != 0;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  if (ok) {
+    verify_report(wrong, k, (end.tv_sec - start.tv_sec) +
+                            (end.tv_nsec - start.tv_nsec) / 1e9);
+  } else {
+    printf("Error en la verificacion: no se pudieron calcular los productos\n");
+  }
+
+  if (!runner->vectors) {
+    free(vectors);
+  }
+  return ok && wrong == 0;
+}
+
+void verify_report(int wrong, int rounds, double seconds) {
+  if (wrong == 0) {
+    printf("Verificacion de Freivalds (%d vectores): correcta\n", rounds);
+  } else {
+    printf("Verificacion de Freivalds (%d vectores): INCORRECTA en %d filas\n",
+           rounds, wrong);
+  }
+  printf("Tiempo de verificacion: %.6f segundos\n", seconds);
+}
@@ -0,0 +1,76 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <stdint.h>
+#include "gemm.h"
+
+// Verificación probabilística de Freivalds: en lugar de repetir A * B
+// (O(n³)) se comprueba A * (B * R) == C * R con k vectores aleatorios
+// R (n x k), en O(k n²). La aritmética es módulo 2^32, como la de los
+// kernels; un C erróneo pasa la prueba con probabilidad despreciable
+// salvo que el error sea múltiplo de una potencia alta de 2
+
+// Quitar "--verify" de los argumentos (para que los programas sigan
+// comprobando solo los posicionales) y devolver 1 si estaba
+int verify_requested(int *argc, char *argv[]);
+
+// Número de vectores k: GEMM_VERIFY_ROUNDS, 8 por defecto
+int verify_rounds(void);
+
+// R[c * k + t] pseudoaleatorios de 32 bits, que dependen solo de la
+// semilla y de la posición (todos los procesos obtienen los mismos)
+void freivalds_vectors(uint32_t *R, int n, int k, uint64_t seed);
+
+// out[r * k + t] = sum_c M[r * ld + c] * R[c * k + t] para una matriz
+// rows x cols por filas con elementos de tipo elem. Compilado con OpenMP
+// las filas se reparten entre los hilos
+void freivalds_apply(const void *M, GemmElem elem, int ld, int rows, int cols,
+                     const uint32_t *R, int k, uint32_t *out);
+
+// Igual para las filas [i0, i0 + rows) de la matriz 'id' de lado n del
+// generador, que se generan por el camino sin guardarse
+void freivalds_apply_generated(int id, uint64_t seed, int n, int i0, int rows,
+                               const uint32_t *R, int k, uint32_t *out);
+
+// Comprobación completa de C = A * B (n x n, B guardada según layout) y
+// mensaje con el resultado y su tiempo. Devuelve 1 si C es correcta
+int freivalds_verify(const void *A, const void *B, GemmElem elem,
+                     GemmLayout layout, const int32_t *C, int n, uint64_t seed);
+
+// Uno de los tres productos de freivalds_verify: out = M * R, con M n x n
+// por filas (o guardada traspuesta si transposed) y R n x k
+typedef struct {
+  const void *M;
+  GemmElem elem;
+  int transposed;
+  int n;
+  const uint32_t *R;
+  int k;
+  uint32_t *out;
+} FreivaldsStep;
+
+// Filas [r0, r1) de out. No reserva memoria: se puede llamar por franjas
+// desde los hilos o los procesos de un pool
+void freivalds_step_rows(const FreivaldsStep *s, int r0, int r1);
+
+// Quién calcula los productos en freivalds_verify_with: run hace el paso
+// entero (repartiendo las franjas como quiera) y vuelve al terminar, con 0
+// si ha fallado. vectors son 4 * n * verify_rounds() enteros para R y los
+// productos, visibles para quien ejecuta run (p. ej. en la memoria
+// compartida de un pool de procesos); si es NULL se reservan con malloc
+typedef struct {
+  int (*run)(void *arg, const FreivaldsStep *step);
+  void *arg;
+  uint32_t *vectors;
+} FreivaldsRunner;
+
+// freivalds_verify con los productos repartidos por runner (NULL: entre
+// los hilos de OpenMP, como freivalds_verify)
+int freivalds_verify_with(const void *A, const void *B, GemmElem elem,
+                          GemmLayout layout, const int32_t *C, int n,
+                          uint64_t seed, const FreivaldsRunner *runner);
+
+// Mensaje de resultado (wrong = filas de C que no cumplen la igualdad)
+void verify_report(int wrong, int rounds, double seconds);
+
+#endif
@@ -2,94 +2,119 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <time.h>
-#include <unistd.h>
-#include <sys/wait.h>
-#include <sys/shm.h>
-
-// Generar una matriz cuadrada NxN con enteros aleatorios
-void generate_matrix(int32_t *matrix, int n) {
-    for (int i = 0; i < n * n; i++) {
-        matrix[i] = rand() % 100;
-    }
+#include "gemm.h"
+#include "rng.h"
+#include "matfile.h"
+#include "verify.h"
+#include "tune.h"
+#include "process-pool.h"
+
+// Productos de la verificación de Freivalds en el pool (FreivaldsRunner)
+int verify_run(void *arg, const FreivaldsStep *step) {
+    ProcessPool *pool = (ProcessPool *)arg;
+    proc_pool_submit_verify(pool, step);
+    return proc_pool_wait(pool);
 }
 
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        printf("Uso: %s <tamano_matriz> <num_procesos>\n", argv[0]);
+    int verify = verify_requested(&argc, argv);
+    uint64_t seed;
+    if (!seed_requested(&argc, argv, &seed)) {
+        printf("La semilla de --seed debe ser un entero sin signo\n");
+        return 1;
+    }
+
+    if (argc != 3 && argc != 4) {
+        printf("Uso: %s <tamano_matriz> <num_procesos> [repeticiones] [--verify] [--seed N]\n", argv[0]);
         return 1;
     }
 
     int n = atoi(argv[1]);
     int num_procs = atoi(argv[2]);
+    int reps = (argc == 4) ? atoi(argv[3]) : 1;
 
-    if (n <= 0 || num_procs <= 0) {
-        printf("El tamaño y número de procesos deben ser positivos\n");
+    if (n <= 0 || num_procs <= 0 || reps <= 0) {
+        printf("El tamaño, número de procesos y repeticiones deben ser positivos\n");
         return 1;
     }
 
-    srand(time(NULL));
+    // Bloques y orden del kernel del perfil de ajuste de la máquina
+    tune_select(n, 1);
+
+    TileConfig tiles;
+    gemm_tiles_init(&tiles);
 
-    // Crear memoria compartida para matrices
-    int shmA = shmget(IPC_PRIVATE, n * n * sizeof(int32_t), IPC_CREAT | 0666);
-    int shmB = shmget(IPC_PRIVATE, n * n * sizeof(int32_t), IPC_CREAT | 0666);
-    int shmC = shmget(IPC_PRIVATE, n * n * sizeof(int32_t), IPC_CREAT | 0666);
+    // Los ficheros se mapean antes de crear los procesos para que estos
+    // hereden los mapeos (MAP_SHARED: lo que escriben en C llega al fichero)
+    MatFile fa, fb, fc;
+    if (!matfile_operand("GEMM_A_FILE", n, seed, MATRIX_A, &fa) ||
+        !matfile_operand("GEMM_B_FILE", n, seed, MATRIX_B, &fb) ||
+        !matfile_result(n, &fc)) {
+        return 1;
+    }
 
-    if (shmA < 0 || shmB < 0 || shmC < 0) {
+    // Los procesos se crean una sola vez; las demás matrices van en la
+    // región compartida que heredan (con un margen de alineación por matriz),
+    // y con --verify también los vectores de Freivalds
+    size_t elems = (size_t)n * n;
+    int in_arena = 1 + !fa.data + !fb.data + !fc.data;
+    size_t vectors = verify ? 4 * (size_t)n * verify_rounds() : 0;
+    ProcessPool *pool = proc_pool_create(num_procs, &tiles,
+                                         in_arena * (elems * sizeof(int32_t) + 64) +
+                                         vectors * sizeof(uint32_t) + 64);
+    if (!pool) {
         perror("Error al crear memoria compartida");
         return 1;
     }
 
-    int32_t *A = (int32_t*)shmat(shmA, NULL, 0);
-    int32_t *B = (int32_t*)shmat(shmB, NULL, 0);
-    int32_t *C = (int32_t*)shmat(shmC, NULL, 0);
+    int32_t *A = fa.data ? fa.data : proc_pool_alloc(pool, elems);
+    int32_t *B = fb.data ? fb.data : proc_pool_alloc(pool, elems);
+    int32_t *C = fc.data ? fc.data : proc_pool_alloc(pool, elems);
+    int32_t *Bt = proc_pool_alloc(pool, elems);
+
+    // Llenar matrices con números aleatorios desde todos los procesos del
+    // pool, por bloques (el generador no depende de quién calcula cada uno)
+    int32_t *generate[2] = { fa.data ? NULL : A, fb.data ? NULL : B };
+    int ids[2] = { MATRIX_A, MATRIX_B };
+    for (int m = 0; m < 2; m++) {
+        if (generate[m] == NULL) {
+            continue;
+        }
+        proc_pool_submit_generate(pool, generate[m], n, seed, ids[m]);
+        if (!proc_pool_wait(pool)) {
+            printf("Un proceso del pool ha terminado de forma inesperada\n");
+            proc_pool_destroy(pool);
+            return 1;
+        }
+    }
+
+    // Transponer B una sola vez con el pool, en una etapa aparte: todas las
+    // versiones pasan al kernel B[j * n + k]
+    struct timespec t_start, t_end;
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
 
-    if (!A || !B || !C) {
-        perror("Error en shmat");
+    proc_pool_submit_transpose(pool, B, Bt, n);
+    if (!proc_pool_wait(pool)) {
+        printf("Un proceso del pool ha terminado de forma inesperada\n");
+        proc_pool_destroy(pool);
         return 1;
     }
 
-    // Llenar matrices con números aleatorios
-    generate_matrix(A, n);
-    generate_matrix(B, n);
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    double t_transpose = (t_end.tv_sec - t_start.tv_sec) +
+                         (t_end.tv_nsec - t_start.tv_nsec) / 1e9;
 
     // Medir tiempo
     struct timespec start, end;
     clock_gettime(CLOCK_MONOTONIC, &start);
 
-    // Crear procesos
-    for (int p = 0; p < num_procs; p++) {
-        pid_t pid = fork();
-
-        if (pid < 0) {
-            perror("Error en fork");
+    for (int r = 0; r < reps; r++) {
+        proc_pool_submit(pool, A, Bt, C, n, GEMM_B_TRANSPOSED);
+        if (!proc_pool_wait(pool)) {
+            printf("Un proceso del pool ha terminado de forma inesperada\n");
+            proc_pool_destroy(pool);
             return 1;
         }
-        if (pid == 0) {
-            // Proceso hijo
-            int filas_por_proceso = n / num_procs;
-            int inicio = p * filas_por_proceso;
-            int fin = (p == num_procs - 1) ? n : inicio + filas_por_proceso;
-
-            for (int i = inicio; i < fin; i++) {
-                for (int j = 0; j < n; j++) {
-                    int32_t sum = 0;
-                    for (int k = 0; k < n; k++) {
-                        sum += A[i * n + k] * B[k * n + j];
-                    }
-                    C[i * n + j] = sum;
-                }
-            }
-            // Salir del hijo
-            shmdt(A);
-            shmdt(B);
-            shmdt(C);
-            exit(0);
-        }
-    }
-
-    // Esperar a todos los hijos
-    for (int i = 0; i < num_procs; i++) {
-        wait(NULL);
     }
 
     clock_gettime(CLOCK_MONOTONIC, &end);
@@ -124,15 +149,33 @@ int main(int argc, char *argv[]) {
     }
 
     printf("Tiempo de multiplicacion con %d procesos: %.6f segundos\n",
-           num_procs, elapsed);
+           num_procs, elapsed / reps);
+    if (reps > 1) {
+        printf("Tiempo total de %d multiplicaciones: %.6f segundos\n",
+               reps, elapsed);
+    }
+    printf("Tiempo de transposicion de B: %.6f segundos\n", t_transpose);
+    if (pool->huge_pages) {
+        printf("Memoria compartida con paginas enormes\n");
+    }
+
+    // Comprobar C = A * B con Freivalds (--verify), repartida en el pool
+    int correcto = 1;
+    if (verify) {
+        FreivaldsRunner runner = { verify_run, pool,
+                                   (uint32_t *)proc_pool_alloc(pool, vectors) };
+        correcto = freivalds_verify_with(A, Bt, GEMM_INT32, GEMM_B_TRANSPOSED,
+                                         C, n, seed, &runner);
+    }
 
-    // Liberar memoria compartida
-    shmdt(A);
-    shmdt(B);
-    shmdt(C);
-    shmctl(shmA, IPC_RMID, NULL);
-    shmctl(shmB, IPC_RMID, NULL);
-    shmctl(shmC, IPC_RMID, NULL);
+    // Parar los procesos y liberar la memoria compartida
+    proc_pool_destroy(pool);
+    matfile_close(&fa);
+    matfile_close(&fb);
+    if (!matfile_close(&fc)) {
+        printf("Error al escribir C\n");
+        return 1;
+    }
 
-    return 0;
+    return correcto ? 0 : 1;
 }
@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "process-pool.h"
+#include "transpose.h"
+#include "rng.h"
+#include "perfctr.h"
+
+#define HUGE_PAGE_SIZE (2UL * 1024 * 1024)
+#define ARENA_ALIGN 64
+
+// Cada cuánto comprueba el padre que los hijos siguen vivos mientras espera
+#define WAIT_CHECK_NS 100000000L
+
+// Futex entre procesos: la región es MAP_SHARED, así que no vale la
+// variante _PRIVATE
+static void futex_wait(_Atomic uint32_t *addr, uint32_t expected,
+                       const struct timespec *timeout) {
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT, expected, timeout, NULL, 0);
+}
+
+static void futex_wake_all(_Atomic uint32_t *addr) {
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+// Región compartida anónima, con páginas enormes si se piden y hay
+static void *map_shared(size_t *size, int *huge) {
+    const char *value = getenv("GEMM_HUGEPAGES");
+    *huge = 0;
+
+    if (value != NULL && atoi(value) > 0) {
+        size_t rounded = (*size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        void *p = mmap(NULL, rounded, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            *size = rounded;
+            *huge = 1;
+            return p;
+        }
+        fprintf(stderr, "GEMM_HUGEPAGES: no hay paginas enormes, se usan normales\n");
+    }
+
+    void *p = mmap(NULL, *size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    return (p == MAP_FAILED) ? NULL : p;
+}
+
+// Bucle de cada hijo: esperar un job nuevo en seq, reclamar bloques hasta
+// agotarlos y avisar al padre si es el último en terminar. El padre no
+// lanza otro job hasta que todos han terminado, así que ningún hijo puede
+// reclamar bloques de un job con los datos de otro. Con PERFCTR=1 cada hijo
+// cuenta sus multiplicaciones e informa al terminar, como proceso 'id'
+static void worker(ProcessPool *pool, int id) {
+    SharedQueue *q = pool->queue;
+    const TileConfig *tiles = &pool->tiles;
+    PerfPhase *perf = perfctr_phase_create("multiply_matrices");
+    uint32_t seen = 0;
+
+    for (;;) {
+        uint32_t s;
+        while ((s = atomic_load(&q->seq)) == seen) {
+            futex_wait(&q->seq, seen, NULL);
+        }
+        seen = s;
+        if (atomic_load(&q->shutdown)) {
+            perfctr_phase_finish(perf, id);
+            return;
+        }
+
+        int gemm = (q->kind == PROC_JOB_GEMM);
+        if (gemm) {
+            perfctr_enter(perf, 0);
+        }
+
+        int b;
+        while ((b = atomic_fetch_add(&q->next_block, 1)) < q->num_blocks) {
+            int i0 = (b / q->blocks_j) * tiles->mc;
+            int j0 = (b % q->blocks_j) * tiles->nc;
+            int i1 = (i0 + tiles->mc < q->n) ? i0 + tiles->mc : q->n;
+            int j1 = (j0 + tiles->nc < q->n) ? j0 + tiles->nc : q->n;
+            if (q->kind == PROC_JOB_TRANSPOSE) {
+                transpose_rect(q->A + (size_t)i0 * q->n + j0, q->n,
+                               q->C + (size_t)j0 * q->n + i0, q->n,
+                               i1 - i0, j1 - j0);
+            } else if (q->kind == PROC_JOB_VERIFY) {
+                freivalds_step_rows(&q->step, i0, i1);
+            } else if (q->kind == PROC_JOB_GENERATE) {
+                generate_block(q->C + (size_t)i0 * q->n + j0, q->n, q->seed,
+                               q->id, q->n, i0, i1 - i0, j0, j1 - j0,
+                               GEMM_B_NORMAL);
+            } else {
+                gemm_block(q->A, q->B, q->C, q->n, q->layout, i0, i1, j0, j1,
+                           tiles);
+            }
+        }
+
+        if (gemm) {
+            perfctr_leave(perf, 0);
+        }
+
+        if (atomic_fetch_add(&q->finished, 1) + 1 == pool->num_procs) {
+            atomic_store(&q->done_seq, s);
+            futex_wake_all(&q->done_seq);
+        }
+    }
+}
+
+ProcessPool *proc_pool_create(int num_procs, const TileConfig *tiles,
+                              size_t arena_size) {
+    ProcessPool *pool = (ProcessPool *)calloc(1, sizeof(ProcessPool));
+    if (!pool) {
+        return NULL;
+    }
+
+    size_t header = (sizeof(SharedQueue) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    pool->map_size = header + arena_size;
+    pool->queue = (SharedQueue *)map_shared(&pool->map_size, &pool->huge_pages);
+    pool->pids = (pid_t *)malloc(num_procs * sizeof(pid_t));
+    if (!pool->queue || !pool->pids) {
+        if (pool->queue) {
+            munmap(pool->queue, pool->map_size);
+        }
+        free(pool->pids);
+        free(pool);
+        return NULL;
+    }
+
+    // mmap anónimo ya viene a cero: seq = done_seq = 0, sin job
+    pool->arena = (char *)pool->queue + header;
+    pool->arena_size = pool->map_size - header;
+    pool->tiles = *tiles;
+    pool->num_procs = num_procs;
+
+    for (int p = 0; p < num_procs; p++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("Error en fork");
+            pool->num_procs = p;
+            proc_pool_destroy(pool);
+            return NULL;
+        }
+        if (pid == 0) {
+            worker(pool, p);
+            _exit(0);
+        }
+        pool->pids[p] = pid;
+    }
+
+    return pool;
+}
+
+int32_t *proc_pool_alloc(ProcessPool *pool, size_t count) {
+    size_t bytes = (count * sizeof(int32_t) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (pool->arena_used + bytes > pool->arena_size) {
+        return NULL;
+    }
+
+    int32_t *p = (int32_t *)(pool->arena + pool->arena_used);
+    pool->arena_used += bytes;
+    return p;
+}
+
+// Escribir el job en la cola compartida y despertar a los hijos
+static void submit_job(ProcessPool *pool, ProcJobKind kind, const int32_t *A,
+                       const int32_t *B, int32_t *C, int n, GemmLayout layout) {
+    SharedQueue *q = pool->queue;
+
+    q->kind = kind;
+    q->A = A;
+    q->B = B;
+    q->C = C;
+    q->n = n;
+    q->layout = layout;
+    // La verificación va por franjas de filas enteras
+    q->blocks_j = (kind == PROC_JOB_VERIFY) ? 1 : gemm_num_blocks(n, pool->tiles.nc);
+    q->num_blocks = gemm_num_blocks(n, pool->tiles.mc) * q->blocks_j;
+    atomic_store(&q->next_block, 0);
+    atomic_store(&q->finished, 0);
+
+    // Publicar el job: el incremento de seq hace visibles los datos de arriba
+    atomic_fetch_add(&q->seq, 1);
+    futex_wake_all(&q->seq);
+}
+
+void proc_pool_submit(ProcessPool *pool, const int32_t *A, const int32_t *B,
+                      int32_t *C, int n, GemmLayout layout) {
+    submit_job(pool, PROC_JOB_GEMM, A, B, C, n, layout);
+}
+
+void proc_pool_submit_transpose(ProcessPool *pool, const int32_t *src,
+                                int32_t *dst, int n) {
+    submit_job(pool, PROC_JOB_TRANSPOSE, src, NULL, dst, n, GEMM_B_NORMAL);
+}
+
+void proc_pool_submit_generate(ProcessPool *pool, int32_t *dst, int n,
+                               uint64_t seed, int id) {
+    pool->queue->seed = seed;
+    pool->queue->id = id;
+    submit_job(pool, PROC_JOB_GENERATE, NULL, NULL, dst, n, GEMM_B_NORMAL);
+}
+
+void proc_pool_submit_verify(ProcessPool *pool, const FreivaldsStep *step) {
+    pool->queue->step = *step;
+    submit_job(pool, PROC_JOB_VERIFY, NULL, NULL, NULL, step->n, GEMM_B_NORMAL);
+}
+
+int proc_pool_wait(ProcessPool *pool) {
+    SharedQueue *q = pool->queue;
+    uint32_t s = atomic_load(&q->seq);
+    struct timespec timeout = { 0, WAIT_CHECK_NS };
+
+    uint32_t done;
+    while ((done = atomic_load(&q->done_seq)) != s) {
+        futex_wait(&q->done_seq, done, &timeout);
+
+        // Un hijo caído no avisará nunca: sus bloques reclamados se pierden
+        int status;
+        pid_t dead = waitpid(-1, &status, WNOHANG);
+        if (dead > 0) {
+            for (int p = 0; p < pool->num_procs; p++) {
+                if (pool->pids[p] == dead) {
+                    pool->pids[p] = 0;
+                }
+            }
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void proc_pool_destroy(ProcessPool *pool) {
+    SharedQueue *q = pool->queue;
+
+    atomic_store(&q->shutdown, 1);
+    atomic_fetch_add(&q->seq, 1);
+    futex_wake_all(&q->seq);
+
+    for (int p = 0; p < pool->num_procs; p++) {
+        if (pool->pids[p] > 0) {
+            waitpid(pool->pids[p], NULL, 0);
+        }
+    }
+
+    munmap(pool->queue, pool->map_size);
+    free(pool->pids);
+    free(pool);
+}
@@ -0,0 +1,91 @@
+#ifndef PROCESS_POOL_H
+#define PROCESS_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+#include "gemm.h"
+#include "verify.h"
+
+// Tipos de job: multiplicación C = A * B, transposición C = A^T,
+// generación de C con el generador de matrices o un producto de la
+// verificación de Freivalds
+typedef enum {
+    PROC_JOB_GEMM = 0,
+    PROC_JOB_TRANSPOSE = 1,
+    PROC_JOB_GENERATE = 2,
+    PROC_JOB_VERIFY = 3
+} ProcJobKind;
+
+// Estado compartido entre el padre y los procesos del pool (al principio de
+// la región mmap). Los bloques mc x nc de C se reparten con un fetch-add
+// sobre next_block; seq y done_seq son además palabras de futex
+typedef struct {
+    _Atomic uint32_t seq;      // número del job actual (los hijos esperan aquí)
+    _Atomic uint32_t done_seq; // último job terminado (el padre espera aquí)
+    _Atomic int next_block;    // siguiente bloque sin reclamar
+    _Atomic int finished;      // hijos que ya no tienen bloques del job
+    _Atomic int shutdown;
+    // Job actual; lo escribe el padre antes de incrementar seq
+    ProcJobKind kind;
+    const int32_t *A, *B;
+    int32_t *C;
+    int n;
+    GemmLayout layout;
+    uint64_t seed;             // semilla y matriz de PROC_JOB_GENERATE
+    int id;
+    FreivaldsStep step;        // producto de PROC_JOB_VERIFY
+    int blocks_j;
+    int num_blocks;
+} SharedQueue;
+
+// Pool de procesos creado con fork una sola vez. Las matrices deben vivir en
+// su región compartida (proc_pool_alloc), que los hijos heredan en la misma
+// dirección; fuera de ella cada proceso tiene su propia memoria
+typedef struct {
+    SharedQueue *queue;
+    char *arena;
+    size_t arena_size;
+    size_t arena_used;
+    size_t map_size;
+    pid_t *pids;
+    int num_procs;
+    TileConfig tiles;
+    int huge_pages; // la región usa páginas enormes (MAP_HUGETLB)
+} ProcessPool;
+
+// Reservar la región compartida de arena_size bytes y lanzar los procesos.
+// Con GEMM_HUGEPAGES=1 se intenta MAP_HUGETLB. Devuelve NULL si falla
+ProcessPool *proc_pool_create(int num_procs, const TileConfig *tiles,
+                              size_t arena_size);
+
+// Reservar count enteros de la región compartida; NULL si no caben
+int32_t *proc_pool_alloc(ProcessPool *pool, size_t count);
+
+// Lanzar C = A * B en los hijos sin esperar (un job a la vez)
+void proc_pool_submit(ProcessPool *pool, const int32_t *A, const int32_t *B,
+                      int32_t *C, int n, GemmLayout layout);
+
+// Lanzar dst = src^T (n x n) en los hijos, por bloques, sin esperar
+void proc_pool_submit_transpose(ProcessPool *pool, const int32_t *src,
+                                int32_t *dst, int n);
+
+// Lanzar la generación de la matriz 'id' (n x n, por filas) con la
+// semilla seed en dst, por bloques, sin esperar
+void proc_pool_submit_generate(ProcessPool *pool, int32_t *dst, int n,
+                               uint64_t seed, int id);
+
+// Lanzar un producto de la verificación de Freivalds en los hijos, por
+// franjas de mc filas, sin esperar. Sus matrices y vectores deben estar en
+// la región compartida (o en ficheros mapeados antes de crear el pool)
+void proc_pool_submit_verify(ProcessPool *pool, const FreivaldsStep *step);
+
+// Esperar a que termine el job; el padre duerme en un futex. Devuelve 0 si
+// algún hijo ha terminado de forma inesperada
+int proc_pool_wait(ProcessPool *pool);
+
+// Parar los hijos y liberar la región
+void proc_pool_destroy(ProcessPool *pool);
+
+#endif
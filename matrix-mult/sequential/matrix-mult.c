@@ -2,38 +2,50 @@
 #include <stdlib.h>
 #include <time.h>
 #include <stdint.h>
+#include "gemm.h"
+#include "rng.h"
+#include "transpose.h"
+#include "matfile.h"
+#include "verify.h"
+#include "tune.h"
+#include "ooc.h"
+#include "sparse.h"
+#include "perfctr.h"
 
 // Generar una matriz cuadrada NxN con enteros aleatorios
-void generate_matrix(int32_t *matrix, int n)
+void generate_matrix(int32_t *matrix, int n, uint64_t seed, int id)
 {
-  for (int i = 0; i < n * n; i++)
-  {
-    matrix[i] = rand() % 100; // valores pequeños para evitar overflow
-  }
+  generate_matrix_philox(matrix, n, seed, id, GEMM_B_NORMAL);
 }
 
-// Multiplicar matrices cuadradas: C = A * B
-void multiply_matrices(int32_t *A, int32_t *B, int32_t *C, int n)
+// Multiplicar matrices cuadradas: C = A * B (B transpuesta, A y B con
+// elementos de tipo elem)
+void multiply_matrices(const void *A, const void *B, GemmElem elem, int32_t *C,
+                       int n)
 {
-  for (int i = 0; i < n; i++)
-  {
-    for (int j = 0; j < n; j++)
-    {
-      int32_t sum = 0;
-      for (int k = 0; k < n; k++)
-      {
-        sum += A[i * n + k] * B[k * n + j];
-      }
-      C[i * n + j] = sum;
-    }
-  }
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+
+  PerfPhase *perf = perfctr_phase_create("multiply_matrices");
+  perfctr_enter(perf, 0);
+  gemm_rows_narrow(A, B, elem, C, n, GEMM_B_TRANSPOSED, 0, n, &tiles);
+  perfctr_leave(perf, 0);
+  perfctr_phase_finish(perf, 0);
 }
 
 int main(int argc, char *argv[])
 {
+  int verify = verify_requested(&argc, argv);
+  uint64_t seed;
+  if (!seed_requested(&argc, argv, &seed))
+  {
+    printf("La semilla de --seed debe ser un entero sin signo\n");
+    return 1;
+  }
+
   if (argc != 2)
   {
-    printf("Uso: %s <tamano_matriz>\n", argv[0]);
+    printf("Uso: %s <tamano_matriz> [--verify] [--seed N]\n", argv[0]);
     return 1;
   }
 
@@ -44,12 +56,39 @@ int main(int argc, char *argv[])
     return 1;
   }
 
-  srand(time(NULL));
+  // Bloques y orden del kernel del perfil de ajuste de la máquina
+  tune_select(n, 1);
+
+  // Fuera de núcleo: A, B y C se quedan en disco y se leen por paneles
+  if (ooc_enabled())
+  {
+    OocStats stats;
+    if (!ooc_run(n, seed, &stats))
+    {
+      return 1;
+    }
+    printf("Tiempo de multiplicacion fuera de nucleo: %.6f segundos\n",
+           stats.seconds);
+    printf("Espera de E/S: %.6f segundos, %.1f MB leidos\n",
+           stats.io_wait_seconds, stats.bytes_read / 1e6);
+    printf("Paneles de %d filas de A y C y %d filas de B\n",
+           stats.panel_rows, stats.panel_depth);
+    return (!verify || ooc_verify(seed)) ? 0 : 1;
+  }
+
+  // Operandos y resultado en ficheros mapeados si se piden
+  MatFile fa, fb, fc;
+  if (!matfile_operand("GEMM_A_FILE", n, seed, MATRIX_A, &fa) ||
+      !matfile_operand("GEMM_B_FILE", n, seed, MATRIX_B, &fb) ||
+      !matfile_result(n, &fc))
+  {
+    return 1;
+  }
 
   // Reservar memoria dinámica
-  int32_t *A = (int32_t *)malloc(n * n * sizeof(int32_t));
-  int32_t *B = (int32_t *)malloc(n * n * sizeof(int32_t));
-  int32_t *C = (int32_t *)malloc(n * n * sizeof(int32_t));
+  int32_t *A = fa.data ? fa.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *B = fb.data ? fb.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *C = fc.data ? fc.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
 
   if (!A || !B || !C)
   {
@@ -58,14 +97,68 @@ int main(int argc, char *argv[])
   }
 
   // Llenar matrices con números aleatorios
-  generate_matrix(A, n);
-  generate_matrix(B, n);
+  if (!fa.data)
+  {
+    generate_matrix(A, n, seed, MATRIX_A);
+  }
+  if (!fb.data)
+  {
+    generate_matrix(B, n, seed, MATRIX_B);
+  }
+
+  // Transponer B una sola vez, en una etapa aparte: todas las versiones
+  // pasan al kernel B[j * n + k]
+  double t_transpose;
+  int32_t *Bt = transpose_stage(B, n, &t_transpose);
+  if (!Bt)
+  {
+    printf("Error al asignar memoria\n");
+    return 1;
+  }
+  matfile_release(&fb, B);
+  B = Bt;
+
+  // Camino disperso: si A o B tienen pocos no nulos se comprimen en CSR o
+  // CSC y se multiplica sin el kernel denso
+  SparsePlan plan;
+  if (!sparse_plan_create(A, B, n, &plan))
+  {
+    printf("Error al asignar memoria\n");
+    return 1;
+  }
+
+  // Modo estrecho: A y B pasan a int8 o int16 si sus valores caben
+  GemmElem elem = GEMM_INT32;
+  void *An = A, *Bn = B;
+  if (gemm_narrow_enabled() && plan.kind == SPARSE_NONE)
+  {
+    elem = gemm_narrow_elem(A, B, (size_t)n * n);
+    if (elem != GEMM_INT32)
+    {
+      An = gemm_narrow_copy(A, (size_t)n * n, elem);
+      Bn = gemm_narrow_copy(B, (size_t)n * n, elem);
+      if (!An || !Bn)
+      {
+        printf("Error al asignar memoria\n");
+        return 1;
+      }
+      matfile_release(&fa, A);
+      free(B);
+    }
+  }
 
   // Medir tiempo
   struct timespec start, end;
   clock_gettime(CLOCK_MONOTONIC, &start);
 
-  multiply_matrices(A, B, C, n);
+  if (plan.kind != SPARSE_NONE)
+  {
+    sparse_multiply(&plan, A, C, n);
+  }
+  else
+  {
+    multiply_matrices(An, Bn, elem, C, n);
+  }
 
   clock_gettime(CLOCK_MONOTONIC, &end);
 
@@ -78,7 +171,7 @@ int main(int argc, char *argv[])
     printf("Matriz A:\n");
     for (int i = 0; i < n; i++) {
       for (int j = 0; j < n; j++) {
-        printf("%d ", A[i * n + j]);
+        printf("%d ", gemm_narrow_at(An, elem, i * n + j));
       }
       printf("\n");
     }
@@ -86,7 +179,7 @@ int main(int argc, char *argv[])
     printf("Matriz B:\n");
     for (int i = 0; i < n; i++) {
       for (int j = 0; j < n; j++) {
-        printf("%d ", B[i * n + j]);
+        printf("%d ", gemm_narrow_at(Bn, elem, j * n + i));
       }
       printf("\n");
     }
@@ -102,11 +195,39 @@ int main(int argc, char *argv[])
 
   // Mostrar tiempo de ejecución
   printf("Tiempo de multiplicacion: %.6f segundos\n", elapsed);
+  printf("Tiempo de transposicion de B: %.6f segundos\n", t_transpose);
+  if (plan.kind != SPARSE_NONE)
+  {
+    printf("Multiplicacion dispersa: %s (densidad de A %.3f, de B %.3f)\n",
+           sparse_kind_name(plan.kind), plan.density_a, plan.density_b);
+    printf("Tiempo de muestreo y compresion: %.6f segundos\n", plan.seconds);
+  }
+  if (gemm_narrow_enabled())
+  {
+    printf("Elementos de A y B de %d bytes\n", (int)elem);
+  }
+
+  // Comprobar C = A * B con Freivalds (--verify)
+  int correcto = !verify || freivalds_verify(An, Bn, elem,
+                                             GEMM_B_TRANSPOSED, C, n, seed);
 
   // Liberar memoria
-  free(A);
-  free(B);
-  free(C);
+  sparse_plan_free(&plan);
+  if (elem == GEMM_INT32)
+  {
+    matfile_release(&fa, A);
+    free(B);
+  }
+  else
+  {
+    free(An);
+    free(Bn);
+  }
+  if (!matfile_release(&fc, C))
+  {
+    printf("Error al escribir C\n");
+    return 1;
+  }
 
-  return 0;
+  return correcto ? 0 : 1;
 }
\ No newline at end of file
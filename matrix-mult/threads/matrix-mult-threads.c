@@ -2,101 +2,189 @@
 #include <stdlib.h>
 #include <time.h>
 #include <stdint.h>
-#include <pthread.h>
+#include "gemm.h"
+#include "rng.h"
+#include "transpose.h"
+#include "matfile.h"
+#include "verify.h"
+#include "tune.h"
+#include "placement.h"
+#include "thread-pool.h"
 
 typedef struct {
-  int id;          // ID del hilo
-  int n;           // tamaño de la matriz
-  int num_threads; // número total de hilos
   int32_t *A, *B, *C;
-} ThreadData;
+  int n;
+  uint64_t seed;
+} TouchData;
 
-// Generar una matriz cuadrada NxN con enteros aleatorios
-void generate_matrix(int32_t *matrix, int n) {
-  for (int i = 0; i < n * n; i++) {
-    matrix[i] = rand() % 100;
+typedef struct {
+  const int32_t *src;
+  int32_t *dst;
+  int n;
+} TransposeData;
+
+// Primer contacto desde el pool: el hilo que calculará el bloque de C
+// genera ese bloque de A (y de B) y pone a cero el de C. A o B a NULL si
+// vienen de fichero
+void touch_block(void *arg, int node, int i0, int i1, int j0, int j1) {
+  TouchData *data = (TouchData*)arg;
+  int n = data->n;
+
+  first_touch_block(data->A, data->C, n, data->seed, i0, i1, j0, j1);
+  if (data->B != NULL) {
+    generate_block(data->B + (size_t)i0 * n + j0, n, data->seed, MATRIX_B, n,
+                   i0, i1 - i0, j0, j1 - j0, GEMM_B_NORMAL);
   }
 }
 
-// Función que ejecutará cada hilo
-void* thread_multiply(void* arg) {
-  ThreadData *data = (ThreadData*)arg;
+// Transponer el bloque [i0, i1) x [j0, j1) de B en el pool
+void transpose_block(void *arg, int node, int i0, int i1, int j0, int j1) {
+  TransposeData *data = (TransposeData*)arg;
   int n = data->n;
-  int id = data->id;
-  int num_threads = data->num_threads;
-
-  // Dividir las filas entre los hilos
-  int filas_por_hilo = n / num_threads;
-  int inicio = id * filas_por_hilo;
-  int fin = (id == num_threads - 1) ? n : inicio + filas_por_hilo;
-
-  for (int i = inicio; i < fin; i++) {
-    for (int j = 0; j < n; j++) {
-      int32_t sum = 0;
-      for (int k = 0; k < n; k++) {
-        sum += data->A[i * n + k] * data->B[k * n + j];
-      }
-      data->C[i * n + j] = sum;
-    }
+
+  transpose_rect(data->src + (size_t)i0 * n + j0, n,
+                 data->dst + (size_t)j0 * n + i0, n, i1 - i0, j1 - j0);
+}
+
+// Franja de filas [i0, i1) de un producto de la verificación: solo los
+// bloques de la primera columna, para que cada franja se haga una vez
+void verify_block(void *arg, int node, int i0, int i1, int j0, int j1) {
+  if (j0 == 0) {
+    freivalds_step_rows((const FreivaldsStep*)arg, i0, i1);
+  }
+}
+
+// Productos de la verificación de Freivalds en el pool (FreivaldsRunner)
+int verify_run(void *arg, const FreivaldsStep *step) {
+  ThreadPool *pool = (ThreadPool*)arg;
+  PoolJob *job = pool_submit_fn(pool, step->n, verify_block, (void*)step);
+  if (!job) {
+    return 0;
   }
-  return NULL;
+  pool_wait(pool, job);
+  return 1;
 }
 
 int main(int argc, char *argv[]) {
-  if (argc != 3) {
-    printf("Uso: %s <tamano_matriz> <num_hilos>\n", argv[0]);
+  int verify = verify_requested(&argc, argv);
+  uint64_t seed;
+  if (!seed_requested(&argc, argv, &seed)) {
+    printf("La semilla de --seed debe ser un entero sin signo\n");
+    return 1;
+  }
+
+  if (argc != 3 && argc != 4) {
+    printf("Uso: %s <tamano_matriz> <num_hilos> [repeticiones] [--verify] [--seed N]\n", argv[0]);
     return 1;
   }
 
   int n = atoi(argv[1]);
   int num_threads = atoi(argv[2]);
+  int reps = (argc == 4) ? atoi(argv[3]) : 1;
 
-  if (n <= 0 || num_threads <= 0) {
-    printf("El tamaño y número de hilos deben ser positivos\n");
+  if (n <= 0 || num_threads <= 0 || reps <= 0) {
+    printf("El tamaño, número de hilos y repeticiones deben ser positivos\n");
     return 1;
   }
 
-  srand(time(NULL));
+  // Bloques y orden del kernel del perfil de ajuste de la máquina
+  tune_select(n, 1);
+
+  // Operandos y resultado en ficheros mapeados si se piden
+  MatFile fa, fb, fc;
+  if (!matfile_operand("GEMM_A_FILE", n, seed, MATRIX_A, &fa) ||
+      !matfile_operand("GEMM_B_FILE", n, seed, MATRIX_B, &fb) ||
+      !matfile_result(n, &fc)) {
+    return 1;
+  }
 
   // Reservar memoria dinámica
-  int32_t *A = (int32_t*)malloc(n * n * sizeof(int32_t));
-  int32_t *B = (int32_t*)malloc(n * n * sizeof(int32_t));
-  int32_t *C = (int32_t*)malloc(n * n * sizeof(int32_t));
+  int32_t *A = fa.data ? fa.data : (int32_t*)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *B = fb.data ? fb.data : (int32_t*)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *C = fc.data ? fc.data : (int32_t*)malloc((size_t)n * n * sizeof(int32_t));
 
   if (!A || !B || !C) {
     printf("Error al asignar memoria\n");
     return 1;
   }
 
-  // Llenar matrices con números aleatorios
-  generate_matrix(A, n);
-  generate_matrix(B, n);
+  PlacementMode placement = placement_mode();
+  Topology topo;
+  if (placement != PLACEMENT_NONE && !topology_init(&topo)) {
+    printf("No se pudo leer la topologia, se usa GEMM_PLACEMENT=none\n");
+    placement = PLACEMENT_NONE;
+  }
 
-  pthread_t threads[num_threads];
-  ThreadData thread_data[num_threads];
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+
+  // Los hilos se crean una sola vez y se reutilizan en todas las
+  // multiplicaciones
+  ThreadPool *pool = pool_create(num_threads, &tiles,
+                                 (placement != PLACEMENT_NONE) ? &topo : NULL);
+  if (!pool) {
+    printf("Error al crear los hilos\n");
+    return 1;
+  }
+
+  // Llenar matrices con números aleatorios desde todos los hilos del pool.
+  // Con colocación NUMA además cada bloque queda en el nodo del hilo que
+  // lo calculará
+  int32_t **B_nodes = NULL;
+  TouchData touch = { fa.data ? NULL : A, fb.data ? NULL : B, C, n, seed };
+  PoolJob *touch_job = pool_submit_fn(pool, n, touch_block, &touch);
+  if (!touch_job) {
+    printf("Error al asignar memoria\n");
+    return 1;
+  }
+  pool_wait(pool, touch_job);
+
+  // Transponer B una sola vez con el pool, en una etapa aparte: todas las
+  // versiones pasan al kernel B[j * n + k]
+  int32_t *Bt = (int32_t*)malloc((size_t)n * n * sizeof(int32_t));
+  if (!Bt) {
+    printf("Error al asignar memoria\n");
+    return 1;
+  }
+
+  struct timespec t_start, t_end;
+  clock_gettime(CLOCK_MONOTONIC, &t_start);
+
+  TransposeData transpose = { B, Bt, n };
+  PoolJob *transpose_job = pool_submit_fn(pool, n, transpose_block, &transpose);
+  if (!transpose_job) {
+    printf("Error al asignar memoria\n");
+    return 1;
+  }
+  pool_wait(pool, transpose_job);
+
+  clock_gettime(CLOCK_MONOTONIC, &t_end);
+  double t_transpose = (t_end.tv_sec - t_start.tv_sec) +
+                       (t_end.tv_nsec - t_start.tv_nsec) / 1e9;
+  matfile_release(&fb, B);
+  B = Bt;
+
+  if (placement == PLACEMENT_REPLICATE) {
+    B_nodes = replicate_per_node(B, (size_t)n * n, &topo);
+    if (!B_nodes) {
+      printf("Error al asignar memoria\n");
+      return 1;
+    }
+  }
 
-  // Crear hilos
-  for (int i = 0; i < num_threads; i++) {
-    thread_data[i].id = i;
-    thread_data[i].n = n;
-    thread_data[i].num_threads = num_threads;
-    thread_data[i].A = A;
-    thread_data[i].B = B;
-    thread_data[i].C = C;
-  } 
-  
   // Medir tiempo
   struct timespec start, end;
   clock_gettime(CLOCK_MONOTONIC, &start);
 
-  // Crear hilos
-  for (int i = 0; i < num_threads; i++) {
-    pthread_create(&threads[i], NULL, thread_multiply, &thread_data[i]);
-  } 
-
-  // Esperar a que terminen
-  for (int i = 0; i < num_threads; i++) {
-    pthread_join(threads[i], NULL);
+  for (int r = 0; r < reps; r++) {
+    PoolJob *job = B_nodes
+        ? pool_submit_replicated(pool, A, B_nodes, C, n, GEMM_B_TRANSPOSED)
+        : pool_submit(pool, A, B, C, n, GEMM_B_TRANSPOSED);
+    if (!job) {
+      printf("Error al asignar memoria\n");
+      return 1;
+    }
+    pool_wait(pool, job);
   }
 
   clock_gettime(CLOCK_MONOTONIC, &end);
@@ -117,7 +205,7 @@ int main(int argc, char *argv[]) {
     printf("Matriz B:\n");
     for (int i = 0; i < n; i++) {
       for (int j = 0; j < n; j++) {
-        printf("%d ", B[i * n + j]);
+        printf("%d ", B[j * n + i]);
       }
       printf("\n");
     }
@@ -133,12 +221,33 @@ int main(int argc, char *argv[]) {
 
   // Mostrar tiempo de ejecución
   printf("Tiempo de multiplicacion con %d hilos: %.6f segundos\n",
-         num_threads, elapsed);
+         num_threads, elapsed / reps);
+  if (reps > 1) {
+    printf("Tiempo total de %d multiplicaciones: %.6f segundos\n",
+           reps, elapsed);
+  }
+  printf("Tiempo de transposicion de B: %.6f segundos\n", t_transpose);
+  if (placement != PLACEMENT_NONE) {
+    printf("Colocacion %s con %d nodos NUMA\n", placement_name(placement),
+           topo.num_nodes);
+    free_replicas(B_nodes, &topo);
+    topology_free(&topo);
+  }
+
+  // Comprobar C = A * B con Freivalds (--verify), repartida en el pool
+  FreivaldsRunner runner = { verify_run, pool, NULL };
+  int correcto = !verify || freivalds_verify_with(A, B, GEMM_INT32,
+                                                  GEMM_B_TRANSPOSED, C, n,
+                                                  seed, &runner);
+  pool_destroy(pool);
 
   // Liberar memoria
-  free(A);
+  matfile_release(&fa, A);
   free(B);
-  free(C);
+  if (!matfile_release(&fc, C)) {
+    printf("Error al escribir C\n");
+    return 1;
+  }
 
-  return 0;
+  return correcto ? 0 : 1;
 }
@@ -0,0 +1,299 @@
+#include <stdlib.h>
+#include "thread-pool.h"
+
+// Ejecutar el trabajo del job sobre su bloque b
+static void run_block(const PoolJob *job, int b, int node,
+                      const TileConfig *tiles) {
+  int i0 = (b / job->blocks_j) * tiles->mc;
+  int j0 = (b % job->blocks_j) * tiles->nc;
+  int i1 = (i0 + tiles->mc < job->n) ? i0 + tiles->mc : job->n;
+  int j1 = (j0 + tiles->nc < job->n) ? j0 + tiles->nc : job->n;
+
+  job->fn(job->arg, node, i0, i1, j0, j1);
+}
+
+// Bloque de C de una multiplicación enviada con pool_submit
+static void gemm_job_block(void *arg, int node, int i0, int i1, int j0, int j1) {
+  const PoolJob *job = (const PoolJob *)arg;
+  const int32_t *B = job->B_nodes ? job->B_nodes[node] : job->B;
+
+  gemm_block(job->A, B, job->C, job->n, job->layout, i0, i1, j0, j1,
+             job->tiles);
+}
+
+static inline uint64_t range_pack(uint32_t lo, uint32_t hi) {
+  return ((uint64_t)hi << 32) | lo;
+}
+
+// Tomar el primer bloque de la cola propia; -1 si está vacía
+static int deque_pop(TileDeque *d) {
+  uint64_t r = atomic_load(&d->range);
+  uint32_t lo, hi;
+  do {
+    lo = (uint32_t)r;
+    hi = (uint32_t)(r >> 32);
+    if (lo >= hi) {
+      return -1;
+    }
+  } while (!atomic_compare_exchange_weak(&d->range, &r, range_pack(lo + 1, hi)));
+  return (int)lo;
+}
+
+// Robar la mitad final (redondeada hacia arriba) de la cola de otro hilo
+static int deque_steal(TileDeque *d, uint32_t *first, uint32_t *last) {
+  uint64_t r = atomic_load(&d->range);
+  uint32_t lo, hi, take;
+  do {
+    lo = (uint32_t)r;
+    hi = (uint32_t)(r >> 32);
+    if (lo >= hi) {
+      return 0;
+    }
+    take = (hi - lo + 1) / 2;
+  } while (!atomic_compare_exchange_weak(&d->range, &r, range_pack(lo, hi - take)));
+  *first = hi - take;
+  *last = hi;
+  return 1;
+}
+
+// Siguiente bloque para el hilo 'id': primero de su cola y, si está vacía,
+// robando a los demás empezando por el vecino. La cola propia solo está
+// vacía cuando se roba, así que nadie más puede estar escribiendo en ella
+static int next_block(PoolJob *job, int id, int num_threads) {
+  int b = deque_pop(&job->deques[id]);
+  if (b >= 0) {
+    return b;
+  }
+
+  for (int k = 1; k < num_threads; k++) {
+    uint32_t first, last;
+    if (deque_steal(&job->deques[(id + k) % num_threads], &first, &last)) {
+      atomic_store(&job->deques[id].range, range_pack(first + 1, last));
+      return (int)first;
+    }
+  }
+  return -1;
+}
+
+// Bucle de cada hilo: tomar el primer job de la cola y vaciar su cola de
+// bloques, robando cuando se acaba. Cuando no queda nada que robar el job
+// sale de la cola, de modo que los hilos que terminan antes pasan al
+// siguiente job sin esperar a los demás
+static void *worker(void *arg) {
+  PoolWorker *self = (PoolWorker *)arg;
+  ThreadPool *pool = self->pool;
+
+  if (self->cpu >= 0) {
+    pin_thread(self->cpu);
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+    while (!pool->head && !pool->shutdown) {
+      pthread_cond_wait(&pool->work, &pool->lock);
+    }
+    if (!pool->head) {
+      break;
+    }
+
+    PoolJob *job = pool->head;
+    job->users++;
+    pthread_mutex_unlock(&pool->lock);
+
+    // Solo se cuentan las multiplicaciones, no el primer contacto ni la
+    // transposición que pasan por pool_submit_fn
+    int gemm = (job->fn == gemm_job_block);
+    if (gemm) {
+      perfctr_enter(pool->perf, self->id);
+    }
+
+    int b;
+    while ((b = next_block(job, self->id, pool->num_threads)) >= 0) {
+      run_block(job, b, self->node, &pool->tiles);
+    }
+
+    if (gemm) {
+      perfctr_leave(pool->perf, self->id);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if (job->queued) {
+      // Los jobs se agotan en orden, así que solo puede ser el primero.
+      // Un bloque robado que aún no está en la cola del ladrón no se pierde:
+      // el ladrón sigue contando en 'users'
+      pool->head = job->next;
+      if (!pool->head) {
+        pool->tail = NULL;
+      }
+      job->queued = 0;
+    }
+    // Fuera de la cola y sin hilos dentro: todos sus bloques están hechos
+    if (--job->users == 0) {
+      pthread_cond_broadcast(&pool->done);
+    }
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  return NULL;
+}
+
+ThreadPool *pool_create(int num_threads, const TileConfig *tiles,
+                        const Topology *topo) {
+  ThreadPool *pool = (ThreadPool *)calloc(1, sizeof(ThreadPool));
+  if (!pool) {
+    return NULL;
+  }
+
+  pool->threads = (pthread_t *)malloc(num_threads * sizeof(pthread_t));
+  pool->workers = (PoolWorker *)malloc(num_threads * sizeof(PoolWorker));
+  if (!pool->threads || !pool->workers) {
+    free(pool->threads);
+    free(pool->workers);
+    free(pool);
+    return NULL;
+  }
+
+  pool->tiles = *tiles;
+  pool->perf = perfctr_phase_create("multiply_matrices");
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  for (int i = 0; i < num_threads; i++) {
+    pool->workers[i].pool = pool;
+    pool->workers[i].id = i;
+    pool->workers[i].node = topo ? topology_node(topo, i, num_threads) : 0;
+    pool->workers[i].cpu = topo ? topology_cpu(topo, i, num_threads) : -1;
+  }
+
+  for (int i = 0; i < num_threads; i++) {
+    if (pthread_create(&pool->threads[i], NULL, worker, &pool->workers[i]) != 0) {
+      break;
+    }
+    pool->num_threads++;
+  }
+
+  // Todos los jobs reparten sus bloques entre num_threads colas
+  if (pool->num_threads < num_threads) {
+    pool_destroy(pool);
+    return NULL;
+  }
+
+  return pool;
+}
+
+// Reservar un job con sus colas de bloques, todavía fuera de la cola
+static PoolJob *job_create(ThreadPool *pool, int n, PoolBlockFn fn, void *arg) {
+  PoolJob *job = (PoolJob *)malloc(sizeof(PoolJob));
+  TileDeque *deques = (TileDeque *)aligned_alloc(
+      sizeof(TileDeque), pool->num_threads * sizeof(TileDeque));
+  if (!job || !deques) {
+    free(job);
+    free(deques);
+    return NULL;
+  }
+
+  job->fn = fn;
+  job->arg = arg;
+  job->n = n;
+  job->B_nodes = NULL;
+  job->blocks_j = gemm_num_blocks(n, pool->tiles.nc);
+  job->num_blocks = gemm_num_blocks(n, pool->tiles.mc) * job->blocks_j;
+  job->deques = deques;
+
+  // Reparto inicial en rangos contiguos (filas de bloques consecutivas);
+  // los primeros num_blocks % num_threads hilos reciben un bloque más
+  int q = job->num_blocks / pool->num_threads;
+  int extra = job->num_blocks % pool->num_threads;
+  for (int t = 0, lo = 0; t < pool->num_threads; t++) {
+    int hi = lo + q + ((t < extra) ? 1 : 0);
+    atomic_init(&deques[t].range, range_pack(lo, hi));
+    lo = hi;
+  }
+  job->users = 0;
+  job->queued = 1;
+  job->next = NULL;
+
+  return job;
+}
+
+static void job_enqueue(ThreadPool *pool, PoolJob *job) {
+  pthread_mutex_lock(&pool->lock);
+  if (pool->tail) {
+    pool->tail->next = job;
+  } else {
+    pool->head = job;
+  }
+  pool->tail = job;
+  pthread_cond_broadcast(&pool->work);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+PoolJob *pool_submit_fn(ThreadPool *pool, int n, PoolBlockFn fn, void *arg) {
+  PoolJob *job = job_create(pool, n, fn, arg);
+  if (job) {
+    job_enqueue(pool, job);
+  }
+  return job;
+}
+
+// Multiplicación: el propio job guarda los operandos
+static PoolJob *submit_gemm(ThreadPool *pool, const int32_t *A,
+                            const int32_t *B, int32_t *const *B_nodes,
+                            int32_t *C, int n, GemmLayout layout) {
+  PoolJob *job = job_create(pool, n, gemm_job_block, NULL);
+  if (!job) {
+    return NULL;
+  }
+
+  job->arg = job;
+  job->A = A;
+  job->B = B;
+  job->B_nodes = B_nodes;
+  job->C = C;
+  job->layout = layout;
+  job->tiles = &pool->tiles;
+  job_enqueue(pool, job);
+  return job;
+}
+
+PoolJob *pool_submit(ThreadPool *pool, const int32_t *A, const int32_t *B,
+                     int32_t *C, int n, GemmLayout layout) {
+  return submit_gemm(pool, A, B, NULL, C, n, layout);
+}
+
+PoolJob *pool_submit_replicated(ThreadPool *pool, const int32_t *A,
+                                int32_t *const *B_nodes, int32_t *C, int n,
+                                GemmLayout layout) {
+  return submit_gemm(pool, A, NULL, B_nodes, C, n, layout);
+}
+
+void pool_wait(ThreadPool *pool, PoolJob *job) {
+  pthread_mutex_lock(&pool->lock);
+  while (job->queued || job->users > 0) {
+    pthread_cond_wait(&pool->done, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  free(job->deques);
+  free(job);
+}
+
+void pool_destroy(ThreadPool *pool) {
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->work);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int i = 0; i < pool->num_threads; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+  perfctr_phase_finish(pool->perf, 0);
+
+  pthread_mutex_destroy(&pool->lock);
+  pthread_cond_destroy(&pool->work);
+  pthread_cond_destroy(&pool->done);
+  free(pool->threads);
+  free(pool->workers);
+  free(pool);
+}
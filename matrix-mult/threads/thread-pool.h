@@ -0,0 +1,96 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "gemm.h"
+#include "placement.h"
+#include "perfctr.h"
+
+// Trabajo sobre el bloque [i0, i1) x [j0, j1) de una matriz n x n; 'node'
+// es el nodo NUMA del hilo que lo ejecuta
+typedef void (*PoolBlockFn)(void *arg, int node, int i0, int i1, int j0, int j1);
+
+// Cola de bloques de un hilo: el rango [lo, hi) de índices de bloque
+// empaquetado en una palabra (hi en los 32 bits altos). El dueño toma
+// bloques por delante y los ladrones roban la mitad de atrás, ambos con CAS.
+// Cada cola ocupa su propia línea de caché
+typedef struct {
+  _Alignas(64) _Atomic uint64_t range;
+} TileDeque;
+
+// Trabajo pendiente (el "future" que devuelven las funciones de envío).
+// La matriz se divide en bloques mc x nc, repartidos al principio en rangos
+// contiguos entre las colas de los hilos; un hilo sin trabajo roba de las
+// demás. Con el mismo n, cada bloque cae siempre en la misma cola
+typedef struct PoolJob {
+  PoolBlockFn fn;
+  void *arg;
+  int n;
+  // Multiplicación de pool_submit (B_nodes: una copia de B por nodo o NULL)
+  const int32_t *A, *B;
+  int32_t *const *B_nodes;
+  int32_t *C;
+  GemmLayout layout;
+  const TileConfig *tiles;
+  int blocks_j;          // bloques por fila
+  int num_blocks;        // bloques en total
+  TileDeque *deques;     // una cola por hilo del pool
+  int users;             // hilos trabajando en el job (protegido por el mutex)
+  int queued;            // sigue en la cola (protegido por el mutex)
+  struct PoolJob *next;
+} PoolJob;
+
+struct ThreadPool;
+
+typedef struct {
+  struct ThreadPool *pool;
+  int id;   // índice de la cola propia en cada job
+  int node; // nodo NUMA del hilo
+  int cpu;  // CPU a la que se fija el hilo, -1 si no se fija
+} PoolWorker;
+
+// Pool de hilos persistente: los hilos se crean una vez y atienden todas
+// las multiplicaciones que se envíen hasta pool_destroy
+typedef struct ThreadPool {
+  pthread_t *threads;
+  PoolWorker *workers;
+  int num_threads;
+  TileConfig tiles;
+  pthread_mutex_t lock;
+  pthread_cond_t work; // hay jobs en la cola o hay que terminar
+  pthread_cond_t done; // algún job ha terminado
+  PoolJob *head, *tail;
+  int shutdown;
+  PerfPhase *perf; // contadores de las multiplicaciones, por hilo (PERFCTR)
+} ThreadPool;
+
+// Crear el pool con num_threads hilos; con topo, el hilo i se fija a
+// topology_cpu(topo, i, num_threads). Devuelve NULL si falla
+ThreadPool *pool_create(int num_threads, const TileConfig *tiles,
+                        const Topology *topo);
+
+// Encolar C = A * B y volver sin esperar; el resultado se recoge con
+// pool_wait. Devuelve NULL si no hay memoria
+PoolJob *pool_submit(ThreadPool *pool, const int32_t *A, const int32_t *B,
+                     int32_t *C, int n, GemmLayout layout);
+
+// Igual, pero cada hilo lee la copia de B de su nodo
+PoolJob *pool_submit_replicated(ThreadPool *pool, const int32_t *A,
+                                int32_t *const *B_nodes, int32_t *C, int n,
+                                GemmLayout layout);
+
+// Encolar fn sobre todos los bloques de una matriz n x n, con el mismo
+// reparto que una multiplicación de tamaño n (p. ej. para el primer
+// contacto de A y C)
+PoolJob *pool_submit_fn(ThreadPool *pool, int n, PoolBlockFn fn, void *arg);
+
+// Esperar a que termine el job y liberarlo
+void pool_wait(ThreadPool *pool, PoolJob *job);
+
+// Terminar los jobs pendientes, parar los hilos y liberar el pool (con
+// PERFCTR=1 informa antes de los contadores de cada hilo)
+void pool_destroy(ThreadPool *pool);
+
+#endif
@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 #include <mpi.h>
+#include "perfctr.h"
 
 void initialize_road(int *road, int N, double density, int seed) {
     srand(seed);
@@ -126,6 +128,10 @@ int main(int argc, char *argv[]) {
     int left_neighbor = (rank - 1 + size) % size;
     int right_neighbor = (rank + 1) % size;
     
+    // Contadores hardware de update_road_local (PERFCTR=1), acumulados entre
+    // pasos y sin contar el intercambio de celdas fantasma
+    PerfPhase *perf = perfctr_phase_create("update_road_local");
+    
     double start_time = MPI_Wtime();
     
     for (int t = 0; t < timesteps; t++) {
@@ -194,8 +200,10 @@ int main(int argc, char *argv[]) {
         
         // Actualizar celdas locales
         int local_moved = 0;
+        perfctr_enter(perf, 0);
         update_road_local(road_old, road_new, local_N, 
                          left_ghost, right_ghost, &local_moved);
+        perfctr_leave(perf, 0);
         
         // Calcular velocidad promedio
         int total_moved = 0;
@@ -220,6 +228,7 @@ int main(int argc, char *argv[]) {
         printf("\nTiempo total de ejecución: %.6f segundos\n", 
                end_time - start_time);
     }
+    perfctr_phase_finish(perf, rank);
     
     free(road_old);
     free(road_new);
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include "perfctr.h"
 
 void initialize_road(int *road, int N, double density) {
     for (int i = 0; i < N; i++) {
@@ -63,12 +64,17 @@ int main(int argc, char *argv[]) {
     printf("N = %d, Timesteps = %d, Densidad = %.2f\n", N, timesteps, density);
     printf("Total de carros: %d\n\n", total_cars);
     
+    // Contadores hardware de update_road (PERFCTR=1), acumulados entre pasos
+    PerfPhase *perf = perfctr_phase_create("update_road");
+    
     // Medición de tiempo
     clock_t start = clock();
     
     for (int t = 0; t < timesteps; t++) {
         int moved_cars = 0;
+        perfctr_enter(perf, 0);
         update_road(road_old, road_new, N, &moved_cars);
+        perfctr_leave(perf, 0);
         
         double velocity = (total_cars > 0) ? (double)moved_cars / total_cars : 0.0;
         
@@ -86,6 +92,7 @@ int main(int argc, char *argv[]) {
     double time_elapsed = (double)(end - start) / CLOCKS_PER_SEC;
     
     printf("\nTiempo total de ejecución: %.6f segundos\n", time_elapsed);
+    perfctr_phase_finish(perf, 0);
     
     free(road_old);
     free(road_new);
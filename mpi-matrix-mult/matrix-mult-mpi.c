@@ -1,76 +1,261 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <stdint.h>
+#include <math.h>
 #include <mpi.h>
+#include "gemm.h"
+#include "rng.h"
+#include "transpose.h"
+#include "verify.h"
+#include "tune.h"
+#include "perfctr.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+// Versión híbrida: un proceso por nodo (o socket) y hilos OpenMP dentro
+#define USO_ARGS "<tamano_matriz> <num_hilos> [filas|summa|cannon|pipeline] [ancho_panel] [--verify] [--seed N]"
+#define PRIMER_OPCIONAL 3
+#else
+#define USO_ARGS "<tamano_matriz> [filas|summa|cannon|pipeline] [ancho_panel] [--verify] [--seed N]"
+#define PRIMER_OPCIONAL 2
+#endif
+
+#define ANCHO_PANEL 256
 
 // Generar una matriz cuadrada NxN con enteros aleatorios
-void generate_matrix(int32_t *matrix, int n)
+void generate_matrix(int32_t *matrix, int n, uint64_t seed, int id)
+{
+  generate_matrix_philox(matrix, n, seed, id, GEMM_B_NORMAL);
+}
+
+void print_matrix(const char *name, int32_t *M, int n)
 {
-  for (int i = 0; i < n * n; i++)
+  printf("Matriz %s:\n", name);
+  for (int i = 0; i < n; i++)
   {
-    matrix[i] = rand() % 100;
+    for (int j = 0; j < n; j++)
+    {
+      printf("%d ", M[i * n + j]);
+    }
+    printf("\n");
   }
 }
 
-// Multiplicar matrices: C_local = A_local * B
-void multiply_matrices(int32_t *A_local, int32_t *B, int32_t *C_local, 
-                       int rows_local, int n)
+// Cada proceso genera solo su parte de A y B, así que para mostrarlas el
+// proceso 0 las regenera completas (solo con matrices pequeñas)
+void print_inputs(int n, uint64_t seed)
 {
-  for (int i = 0; i < rows_local; i++)
+  int32_t *A = (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *B = (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+
+  if (!A || !B)
   {
-    for (int j = 0; j < n; j++)
+    printf("Error al asignar memoria\n");
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  generate_matrix(A, n, seed, MATRIX_A);
+  generate_matrix(B, n, seed, MATRIX_B);
+  print_matrix("A", A, n);
+  print_matrix("B", B, n);
+
+  free(A);
+  free(B);
+}
+
+// Multiplicación local C += A * B (M x K por K x N), con B traspuesta como
+// en el resto de versiones: B[j * ldb + k]. En la versión híbrida los hilos
+// se reparten los bloques mc x nc de C; las llamadas a MPI quedan siempre
+// fuera de la región paralela (MPI_THREAD_FUNNELED). Los contadores de perf
+// se acumulan entre llamadas, por hilo, y solo cuentan el cálculo
+void local_gemm(int M, int N, int K, const int32_t *A, int lda,
+                const int32_t *B, int ldb, int32_t *C, int ldc,
+                const TileConfig *tiles, PerfPhase *perf)
+{
+#ifdef _OPENMP
+  int bloques_i = gemm_num_blocks(M, tiles->mc);
+  int bloques_j = gemm_num_blocks(N, tiles->nc);
+
+  #pragma omp parallel
+  {
+    perfctr_enter(perf, omp_get_thread_num());
+
+    #pragma omp for collapse(2) schedule(dynamic) nowait
+    for (int bi = 0; bi < bloques_i; bi++)
     {
-      int32_t sum = 0;
-      for (int k = 0; k < n; k++)
+      for (int bj = 0; bj < bloques_j; bj++)
       {
-        sum += A_local[i * n + k] * B[k * n + j];
+        int i0 = bi * tiles->mc;
+        int j0 = bj * tiles->nc;
+        int mb = (i0 + tiles->mc < M) ? tiles->mc : M - i0;
+        int nb = (j0 + tiles->nc < N) ? tiles->nc : N - j0;
+        hpc_gemm_i32_tiles(GEMM_NO_TRANS, GEMM_TRANS, mb, nb, K, 1,
+                           A + (size_t)i0 * lda, lda, B + (size_t)j0 * ldb,
+                           ldb, 1, C + (size_t)i0 * ldc + j0, ldc, tiles);
       }
-      C_local[i * n + j] = sum;
     }
+
+    perfctr_leave(perf, omp_get_thread_num());
   }
+#else
+  perfctr_enter(perf, 0);
+  hpc_gemm_i32_tiles(GEMM_NO_TRANS, GEMM_TRANS, M, N, K, 1, A, lda, B, ldb, 1,
+                     C, ldc, tiles);
+  perfctr_leave(perf, 0);
+#endif
 }
 
-int main(int argc, char *argv[])
+// Multiplicar matrices: C_local = A_local * B (B traspuesta)
+void multiply_matrices(int32_t *A_local, int32_t *B, int32_t *C_local,
+                       int rows_local, int n, int rank)
 {
-  int rank, size;
-  MPI_Init(&argc, &argv);
-  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+  PerfPhase *perf = perfctr_phase_create("multiply_matrices");
 
-  if (argc != 2)
+  memset(C_local, 0, (size_t)rows_local * n * sizeof(int32_t));
+  local_gemm(rows_local, n, n, A_local, n, B, n, C_local, n, &tiles, perf);
+  perfctr_phase_finish(perf, rank);
+}
+
+// Tiempo de la etapa de transposición: el máximo entre procesos
+void report_transpose(double seconds, int rank)
+{
+  double max_seconds;
+  MPI_Reduce(&seconds, &max_seconds, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  if (rank == 0)
+    printf("Tiempo de transposicion de B: %.6f segundos\n", max_seconds);
+}
+
+// Transponer un bloque local de B (rows x cols, contiguo) sobre sí mismo,
+// pasando por un buffer temporal
+void transpose_local(int32_t *block, int rows, int cols)
+{
+  int32_t *tmp = (int32_t *)malloc((size_t)rows * cols * sizeof(int32_t));
+  if (!tmp)
   {
-    if (rank == 0)
-      printf("Uso: mpirun -np <procesos> %s <tamano_matriz>\n", argv[0]);
-    MPI_Finalize();
-    return 1;
+    printf("Error al asignar memoria\n");
+    MPI_Abort(MPI_COMM_WORLD, 1);
   }
+  transpose_parallel(block, cols, tmp, rows, rows, cols);
+  memcpy(block, tmp, (size_t)rows * cols * sizeof(int32_t));
+  free(tmp);
+}
 
-  int n = atoi(argv[1]);
-  if (n <= 0)
+// Reparto balanceado de n en q partes: las primeras n % q reciben una más
+int block_size(int n, int q, int r)
+{
+  return n / q + ((r < n % q) ? 1 : 0);
+}
+
+int block_offset(int n, int q, int r)
+{
+  return r * (n / q) + ((r < n % q) ? r : n % q);
+}
+
+// Comprobación de Freivalds repartida (--verify), con todos los procesos:
+// cada uno calcula B * R para su franja de filas de B (generadas, sin
+// guardarlas) y se juntan con Allgatherv; después aporta A * (B * R) para
+// esa misma franja de A y resta C_local * R para su bloque de C (filas
+// [i0, i0 + rows), columnas [j0, j0 + cols)). La suma de las aportaciones
+// en el proceso 0 debe ser nula. Devuelve 1 en todos si C es correcta.
+// Los modos la llaman al terminar si reciben 'correcto' (no NULL)
+int verify_distributed(const int32_t *C_local, int ldc, int i0, int rows,
+                       int j0, int cols, int n, uint64_t seed, int rank,
+                       int size)
+{
+  double start = MPI_Wtime();
+  int k = verify_rounds();
+  int f0 = block_offset(n, size, rank);
+  int filas = block_size(n, size, rank);
+
+  uint32_t *R = (uint32_t *)malloc((size_t)n * k * sizeof(uint32_t));
+  uint32_t *y = (uint32_t *)malloc((size_t)n * k * sizeof(uint32_t));
+  uint32_t *v = (uint32_t *)calloc((size_t)n * k, sizeof(uint32_t));
+  size_t max_filas = (filas > rows) ? filas : rows;
+  uint32_t *parte = (uint32_t *)malloc((max_filas ? max_filas : 1) * k *
+                                       sizeof(uint32_t));
+  int *counts = (int *)malloc(size * sizeof(int));
+  int *displs = (int *)malloc(size * sizeof(int));
+  if (!R || !y || !v || !parte || !counts || !displs)
   {
-    if (rank == 0)
-      printf("El tamaño debe ser positivo\n");
-    MPI_Finalize();
-    return 1;
+    printf("Error al asignar memoria en proceso %d\n", rank);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  freivalds_vectors(R, n, k, seed);
+
+  // y = B * R
+  for (int r = 0; r < size; r++)
+  {
+    counts[r] = block_size(n, size, r) * k;
+    displs[r] = block_offset(n, size, r) * k;
+  }
+  freivalds_apply_generated(MATRIX_B, seed, n, f0, filas, R, k, parte);
+  MPI_Allgatherv(parte, filas * k, MPI_UINT32_T, y, counts, displs,
+                 MPI_UINT32_T, MPI_COMM_WORLD);
+
+  // v = A * y - C * R, con las aportaciones de este proceso
+  freivalds_apply_generated(MATRIX_A, seed, n, f0, filas, y, k, parte);
+  memcpy(v + (size_t)f0 * k, parte, (size_t)filas * k * sizeof(uint32_t));
+  freivalds_apply(C_local, GEMM_INT32, ldc, rows, cols, R + (size_t)j0 * k,
+                  k, parte);
+  for (size_t e = 0; e < (size_t)rows * k; e++)
+    v[(size_t)i0 * k + e] -= parte[e];
+
+  MPI_Reduce((rank == 0) ? MPI_IN_PLACE : v, v, n * k, MPI_UINT32_T, MPI_SUM,
+             0, MPI_COMM_WORLD);
+
+  int wrong = 0;
+  if (rank == 0)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      for (int t = 0; t < k; t++)
+      {
+        if (v[(size_t)i * k + t] != 0)
+        {
+          wrong++;
+          break;
+        }
+      }
+    }
+    verify_report(wrong, k, MPI_Wtime() - start);
   }
+  MPI_Bcast(&wrong, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+  free(R);
+  free(y);
+  free(v);
+  free(parte);
+  free(counts);
+  free(displs);
+  return wrong == 0;
+}
 
+// Modo filas: cada proceso genera sus filas de A, el proceso 0 transpone B
+// y la difunde completa con Bcast, y Gatherv de C
+double run_rows(int n, int rank, int size, uint64_t seed,
+                int *correcto)
+{
   // Calcular filas por proceso de forma balanceada
   int base_rows = n / size;
   int extra_rows = n % size;
-  
+
   // Los primeros 'extra_rows' procesos reciben una fila adicional
   int rows_local = (rank < extra_rows) ? base_rows + 1 : base_rows;
-  
+
   // Calcular desplazamientos para cada proceso
   int *sendcounts = NULL;
   int *displs = NULL;
-  
+
   if (rank == 0)
   {
     sendcounts = (int *)malloc(size * sizeof(int));
     displs = (int *)malloc(size * sizeof(int));
-    
+
     int offset = 0;
     for (int i = 0; i < size; i++)
     {
@@ -80,32 +265,39 @@ int main(int argc, char *argv[])
       offset += rows * n;
     }
   }
-  
-  // Matrices globales (solo el proceso 0 las necesita completas)
-  int32_t *A = NULL;
+
+  // Matrices globales: el proceso 0 genera B y recibe C completa
   int32_t *B = NULL;
   int32_t *C = NULL;
-  
+  double t_transpose = 0.0;
+
   if (rank == 0)
   {
-    srand(time(NULL));
-    A = (int32_t *)malloc(n * n * sizeof(int32_t));
-    B = (int32_t *)malloc(n * n * sizeof(int32_t));
-    C = (int32_t *)malloc(n * n * sizeof(int32_t));
-    
-    if (!A || !B || !C)
+    B = (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+    C = (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+
+    if (!B || !C)
+    {
+      printf("Error al asignar memoria\n");
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    generate_matrix(B, n, seed, MATRIX_B);
+
+    // Transponer B una sola vez, en una etapa aparte
+    int32_t *Bt = transpose_stage(B, n, &t_transpose);
+    if (!Bt)
     {
       printf("Error al asignar memoria\n");
       MPI_Abort(MPI_COMM_WORLD, 1);
     }
-    
-    generate_matrix(A, n);
-    generate_matrix(B, n);
+    free(B);
+    B = Bt;
   }
   else
   {
     // Los demás procesos solo necesitan B completa
-    B = (int32_t *)malloc(n * n * sizeof(int32_t));
+    B = (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
     if (!B)
     {
       printf("Error al asignar memoria en proceso %d\n", rank);
@@ -114,27 +306,26 @@ int main(int argc, char *argv[])
   }
 
   // Matrices locales para cada proceso
-  int32_t *A_local = (int32_t *)malloc(rows_local * n * sizeof(int32_t));
-  int32_t *C_local = (int32_t *)malloc(rows_local * n * sizeof(int32_t));
-  
+  int32_t *A_local = (int32_t *)malloc((size_t)rows_local * n * sizeof(int32_t));
+  int32_t *C_local = (int32_t *)malloc((size_t)rows_local * n * sizeof(int32_t));
+
   if (!A_local || !C_local)
   {
     printf("Error al asignar memoria local en proceso %d\n", rank);
     MPI_Abort(MPI_COMM_WORLD, 1);
   }
 
-  double start_time = MPI_Wtime();
+  // Cada proceso genera directamente sus filas de A
+  generate_block(A_local, n, seed, MATRIX_A, n, block_offset(n, size, rank),
+                 rows_local, 0, n, GEMM_B_NORMAL);
 
-  // Distribuir filas de A entre los procesos con Scatterv
-  MPI_Scatterv(A, sendcounts, displs, MPI_INT32_T,
-               A_local, rows_local * n, MPI_INT32_T,
-               0, MPI_COMM_WORLD);
+  double start_time = MPI_Wtime();
 
   // Broadcast de B a todos los procesos
   MPI_Bcast(B, n * n, MPI_INT32_T, 0, MPI_COMM_WORLD);
 
   // Cada proceso calcula su parte de C
-  multiply_matrices(A_local, B, C_local, rows_local, n);
+  multiply_matrices(A_local, B, C_local, rows_local, n, rank);
 
   // Recolectar resultados en el proceso 0 con Gatherv
   MPI_Gatherv(C_local, rows_local * n, MPI_INT32_T,
@@ -148,40 +339,14 @@ int main(int argc, char *argv[])
   {
     if (n <= 5)
     {
-      printf("Matriz A:\n");
-      for (int i = 0; i < n; i++)
-      {
-        for (int j = 0; j < n; j++)
-        {
-          printf("%d ", A[i * n + j]);
-        }
-        printf("\n");
-      }
-
-      printf("Matriz B:\n");
-      for (int i = 0; i < n; i++)
-      {
-        for (int j = 0; j < n; j++)
-        {
-          printf("%d ", B[i * n + j]);
-        }
-        printf("\n");
-      }
-
-      printf("Matriz C:\n");
-      for (int i = 0; i < n; i++)
-      {
-        for (int j = 0; j < n; j++)
-        {
-          printf("%d ", C[i * n + j]);
-        }
-        printf("\n");
-      }
+      print_inputs(n, seed);
+      print_matrix("C", C, n);
     }
 
-    printf("Tiempo de multiplicacion (MPI con %d procesos): %.6f segundos\n", 
+    printf("Tiempo de multiplicacion (MPI con %d procesos): %.6f segundos\n",
            size, end_time - start_time);
-    
+    printf("Tiempo de transposicion de B: %.6f segundos\n", t_transpose);
+
     // Mostrar distribución de carga
     printf("Distribucion de filas: ");
     for (int i = 0; i < size; i++)
@@ -191,19 +356,597 @@ int main(int argc, char *argv[])
     }
   }
 
+  if (correcto)
+    *correcto = verify_distributed(C_local, n, block_offset(n, size, rank),
+                                   rows_local, 0, n, n, seed, rank, size);
+
   // Liberar memoria
   free(A_local);
   free(C_local);
   free(B);
-  
+
   if (rank == 0)
   {
-    free(A);
     free(C);
     free(sendcounts);
     free(displs);
   }
 
+  return end_time - start_time;
+}
+
+// Malla cartesiana q x q con comunicadores por fila y por columna
+typedef struct
+{
+  MPI_Comm grid;
+  MPI_Comm row_comm; // procesos de la misma fila (rango = columna)
+  MPI_Comm col_comm; // procesos de la misma columna (rango = fila)
+  int q;
+  int my_row, my_col;
+} Grid;
+
+// Crear la malla; devuelve 0 si el número de procesos no es un cuadrado
+int grid_create(Grid *g, int size, int periodic)
+{
+  int q = (int)(sqrt((double)size) + 0.5);
+  if (q * q != size)
+    return 0;
+
+  int dims[2] = {q, q};
+  int periods[2] = {periodic, periodic};
+  int coords[2];
+  int keep_cols[2] = {0, 1};
+  int keep_rows[2] = {1, 0};
+
+  // Sin reordenar: el proceso 0 de la malla es el 0 de MPI_COMM_WORLD
+  MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 0, &g->grid);
+  int grid_rank;
+  MPI_Comm_rank(g->grid, &grid_rank);
+  MPI_Cart_coords(g->grid, grid_rank, 2, coords);
+  MPI_Cart_sub(g->grid, keep_cols, &g->row_comm);
+  MPI_Cart_sub(g->grid, keep_rows, &g->col_comm);
+
+  g->q = q;
+  g->my_row = coords[0];
+  g->my_col = coords[1];
+  return 1;
+}
+
+void grid_free(Grid *g)
+{
+  MPI_Comm_free(&g->row_comm);
+  MPI_Comm_free(&g->col_comm);
+  MPI_Comm_free(&g->grid);
+}
+
+// Generar en 'local' el bloque (r, c) de la matriz 'id' que corresponde a
+// este proceso de la malla, con distancia entre filas ld
+void generate_grid_block(int32_t *local, int ld, int n, uint64_t seed, int id,
+                         const Grid *g)
+{
+  generate_block(local, ld, seed, id, n,
+                 block_offset(n, g->q, g->my_row), block_size(n, g->q, g->my_row),
+                 block_offset(n, g->q, g->my_col), block_size(n, g->q, g->my_col),
+                 GEMM_B_NORMAL);
+}
+
+// Reunir en el proceso 0 los bloques de C; se describen con MPI_Type_vector
+// para recibirlos sin copias intermedias
+void gather_blocks(int32_t *M, int32_t *local, int n, const Grid *g)
+{
+  int rows = block_size(n, g->q, g->my_row);
+  int cols = block_size(n, g->q, g->my_col);
+  int grid_rank;
+  MPI_Comm_rank(g->grid, &grid_rank);
+
+  if (grid_rank != 0)
+  {
+    MPI_Send(local, rows * cols, MPI_INT32_T, 0, 1, g->grid);
+    return;
+  }
+
+  for (int r = 0; r < g->q; r++)
+  {
+    for (int c = 0; c < g->q; c++)
+    {
+      int br = block_size(n, g->q, r);
+      int bc = block_size(n, g->q, c);
+      int32_t *origin = M + (size_t)block_offset(n, g->q, r) * n +
+                        block_offset(n, g->q, c);
+      if (r == 0 && c == 0)
+      {
+        for (int i = 0; i < br; i++)
+          memcpy(origin + (size_t)i * n, local + (size_t)i * bc,
+                 bc * sizeof(int32_t));
+        continue;
+      }
+
+      int src;
+      int coords[2] = {r, c};
+      MPI_Cart_rank(g->grid, coords, &src);
+
+      MPI_Datatype block;
+      MPI_Type_vector(br, bc, n, MPI_INT32_T, &block);
+      MPI_Type_commit(&block);
+      MPI_Recv(origin, 1, block, src, 1, g->grid, MPI_STATUS_IGNORE);
+      MPI_Type_free(&block);
+    }
+  }
+}
+
+// En los modos por bloques C completa solo existe en el proceso 0 y solo
+// para mostrarla (n <= 5)
+int32_t *root_alloc_result(int n)
+{
+  int32_t *C = (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+
+  if (!C)
+  {
+    printf("Error al asignar memoria\n");
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+  return C;
+}
+
+void report_grid(const char *mode, int32_t *C, int n, uint64_t seed,
+                 int size, const Grid *g, double elapsed)
+{
+  if (n <= 5)
+  {
+    print_inputs(n, seed);
+    print_matrix("C", C, n);
+  }
+
+  printf("Tiempo de multiplicacion (MPI %s con %d procesos): %.6f segundos\n",
+         mode, size, elapsed);
+  printf("Malla de procesos: %dx%d, bloques de %dx%d\n",
+         g->q, g->q, block_size(n, g->q, 0), block_size(n, g->q, 0));
+}
+
+// Modo SUMMA: cada proceso genera y guarda solo sus bloques de A, B y C
+// (n²/p). En el paso s la columna s de la malla difunde su bloque de A por
+// las filas y la fila s difunde su bloque de B por las columnas
+double run_summa(int n, int rank, int size, uint64_t seed,
+                 int *correcto)
+{
+  Grid g;
+  if (!grid_create(&g, size, 0))
+  {
+    if (rank == 0)
+      printf("SUMMA requiere un número cuadrado de procesos (p = q*q)\n");
+    return -1.0;
+  }
+
+  int rows = block_size(n, g.q, g.my_row);
+  int cols = block_size(n, g.q, g.my_col);
+  int max_block = block_size(n, g.q, 0);
+
+  int32_t *A_local = (int32_t *)malloc((size_t)rows * cols * sizeof(int32_t));
+  int32_t *B_local = (int32_t *)malloc((size_t)rows * cols * sizeof(int32_t));
+  int32_t *C_local = (int32_t *)calloc((size_t)rows * cols, sizeof(int32_t));
+  int32_t *A_panel = (int32_t *)malloc((size_t)rows * max_block * sizeof(int32_t));
+  int32_t *B_panel = (int32_t *)malloc((size_t)max_block * cols * sizeof(int32_t));
+
+  if (!A_local || !B_local || !C_local || !A_panel || !B_panel)
+  {
+    printf("Error al asignar memoria local en proceso %d\n", rank);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  generate_grid_block(A_local, cols, n, seed, MATRIX_A, &g);
+  generate_grid_block(B_local, cols, n, seed, MATRIX_B, &g);
+
+  // Cada proceso transpone su bloque de B (cols x rows, ld = rows)
+  double t_transpose = MPI_Wtime();
+  transpose_local(B_local, rows, cols);
+  t_transpose = MPI_Wtime() - t_transpose;
+
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+  PerfPhase *perf = perfctr_phase_create("local_gemm summa");
+
+  double start_time = MPI_Wtime();
+
+  for (int s = 0; s < g.q; s++)
+  {
+    int ks = block_size(n, g.q, s);
+    int32_t *a = (g.my_col == s) ? A_local : A_panel;
+    int32_t *b = (g.my_row == s) ? B_local : B_panel;
+
+    MPI_Bcast(a, rows * ks, MPI_INT32_T, s, g.row_comm);
+    MPI_Bcast(b, ks * cols, MPI_INT32_T, s, g.col_comm);
+
+    local_gemm(rows, cols, ks, a, ks, b, ks, C_local, cols, &tiles, perf);
+  }
+
+  double end_time = MPI_Wtime();
+  perfctr_phase_finish(perf, rank);
+
+  // C completa solo para mostrarla, fuera del tiempo medido: con n grande
+  // no cabría en un nodo (la comprobación usa los bloques de cada proceso)
+  int32_t *C = NULL;
+  if (n <= 5)
+  {
+    if (rank == 0)
+      C = root_alloc_result(n);
+    gather_blocks(C, C_local, n, &g);
+  }
+
+  if (rank == 0)
+    report_grid("SUMMA", C, n, seed, size, &g, end_time - start_time);
+  report_transpose(t_transpose, rank);
+
+  if (correcto)
+    *correcto = verify_distributed(C_local, cols,
+                                   block_offset(n, g.q, g.my_row), rows,
+                                   block_offset(n, g.q, g.my_col), cols,
+                                   n, seed, rank, size);
+
+  free(A_local);
+  free(B_local);
+  free(C_local);
+  free(A_panel);
+  free(B_panel);
+
+  if (rank == 0)
+    free(C);
+
+  grid_free(&g);
+  return end_time - start_time;
+}
+
+// Modo Cannon: malla periódica, alineación inicial (A_ij se desplaza i
+// posiciones a la izquierda y B_ij j posiciones hacia arriba) y q rondas de
+// multiplicar y rotar A a la izquierda y B hacia arriba con
+// MPI_Sendrecv_replace. Los buffers tienen el tamaño del bloque mayor para
+// que todos los mensajes sean iguales aunque q no divida a n
+double run_cannon(int n, int rank, int size, uint64_t seed,
+                  int *correcto)
+{
+  Grid g;
+  if (!grid_create(&g, size, 1))
+  {
+    if (rank == 0)
+      printf("Cannon requiere un número cuadrado de procesos (p = q*q)\n");
+    return -1.0;
+  }
+
+  int rows = block_size(n, g.q, g.my_row);
+  int cols = block_size(n, g.q, g.my_col);
+  int max_block = block_size(n, g.q, 0);
+  int a_count = rows * max_block;
+  int b_count = max_block * cols;
+
+  int32_t *A_local = (int32_t *)malloc((size_t)a_count * sizeof(int32_t));
+  int32_t *B_local = (int32_t *)malloc((size_t)b_count * sizeof(int32_t));
+  int32_t *C_local = (int32_t *)calloc((size_t)rows * cols, sizeof(int32_t));
+
+  if (!A_local || !B_local || !C_local)
+  {
+    printf("Error al asignar memoria local en proceso %d\n", rank);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  // Los bloques se generan contiguos (ld = cols) dentro de los buffers del
+  // tamaño máximo, igual que llegarán tras cada rotación
+  generate_grid_block(A_local, cols, n, seed, MATRIX_A, &g);
+  generate_grid_block(B_local, cols, n, seed, MATRIX_B, &g);
+
+  // Cada proceso transpone su bloque de B: el bloque B_kj viaja como
+  // cols x ks con ld = ks
+  double t_transpose = MPI_Wtime();
+  transpose_local(B_local, rows, cols);
+  t_transpose = MPI_Wtime() - t_transpose;
+
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+  PerfPhase *perf = perfctr_phase_create("local_gemm cannon");
+
+  double start_time = MPI_Wtime();
+
+  // Alineación inicial
+  int src, dst;
+  MPI_Cart_shift(g.grid, 1, -g.my_row, &src, &dst);
+  MPI_Sendrecv_replace(A_local, a_count, MPI_INT32_T, dst, 2, src, 2,
+                       g.grid, MPI_STATUS_IGNORE);
+  MPI_Cart_shift(g.grid, 0, -g.my_col, &src, &dst);
+  MPI_Sendrecv_replace(B_local, b_count, MPI_INT32_T, dst, 3, src, 3,
+                       g.grid, MPI_STATUS_IGNORE);
+
+  int left_src, left_dst, up_src, up_dst;
+  MPI_Cart_shift(g.grid, 1, -1, &left_src, &left_dst);
+  MPI_Cart_shift(g.grid, 0, -1, &up_src, &up_dst);
+
+  for (int t = 0; t < g.q; t++)
+  {
+    // En la ronda t cada proceso tiene A_ik y B_kj con k = i + j + t
+    int k = (g.my_row + g.my_col + t) % g.q;
+    int ks = block_size(n, g.q, k);
+
+    local_gemm(rows, cols, ks, A_local, ks, B_local, ks, C_local, cols,
+               &tiles, perf);
+
+    if (t < g.q - 1)
+    {
+      MPI_Sendrecv_replace(A_local, a_count, MPI_INT32_T, left_dst, 4,
+                           left_src, 4, g.grid, MPI_STATUS_IGNORE);
+      MPI_Sendrecv_replace(B_local, b_count, MPI_INT32_T, up_dst, 5,
+                           up_src, 5, g.grid, MPI_STATUS_IGNORE);
+    }
+  }
+
+  double end_time = MPI_Wtime();
+  perfctr_phase_finish(perf, rank);
+
+  // Como en SUMMA, C completa solo para mostrarla y fuera del tiempo
+  int32_t *C = NULL;
+  if (n <= 5)
+  {
+    if (rank == 0)
+      C = root_alloc_result(n);
+    gather_blocks(C, C_local, n, &g);
+  }
+
+  if (rank == 0)
+    report_grid("Cannon", C, n, seed, size, &g, end_time - start_time);
+  report_transpose(t_transpose, rank);
+
+  if (correcto)
+    *correcto = verify_distributed(C_local, cols,
+                                   block_offset(n, g.q, g.my_row), rows,
+                                   block_offset(n, g.q, g.my_col), cols,
+                                   n, seed, rank, size);
+
+  free(A_local);
+  free(B_local);
+  free(C_local);
+
+  if (rank == 0)
+    free(C);
+
+  grid_free(&g);
+  return end_time - start_time;
+}
+
+// Copiar las columnas [j0, j0 + w) de B (n x n) a un panel contiguo w x n ya
+// traspuesto: en este modo la transposición va junto con el empaquetado
+void pack_panel(int32_t *B, int n, int j0, int w, int32_t *panel)
+{
+  transpose_parallel(B + j0, n, panel, n, n, w);
+}
+
+// Modo pipeline: B viaja en paneles de columnas con MPI_Ibcast y doble
+// buffer, de modo que el panel p+1 se transmite mientras se calcula el p.
+// Cada trozo de C (filas locales x panel) se devuelve con MPI_Isend en
+// cuanto se termina. Además, cada proceso guarda solo dos paneles de B
+double run_pipeline(int n, int rank, int size, int panel_width, uint64_t seed,
+                    int *correcto)
+{
+  int w = (panel_width < n) ? panel_width : n;
+  int num_panels = gemm_num_blocks(n, w);
+  int rows_local = block_size(n, size, rank);
+
+  int32_t *B = NULL;
+  int32_t *C = NULL;
+
+  if (rank == 0)
+  {
+    B = (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+    C = root_alloc_result(n);
+    if (!B)
+    {
+      printf("Error al asignar memoria\n");
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    generate_matrix(B, n, seed, MATRIX_B);
+  }
+
+  int32_t *A_local = (int32_t *)malloc((size_t)rows_local * n * sizeof(int32_t));
+  int32_t *C_local = (int32_t *)calloc((size_t)rows_local * n, sizeof(int32_t));
+  int32_t *panel[2];
+  panel[0] = (int32_t *)malloc((size_t)n * w * sizeof(int32_t));
+  panel[1] = (int32_t *)malloc((size_t)n * w * sizeof(int32_t));
+  MPI_Request *send_reqs = (MPI_Request *)malloc(num_panels * sizeof(MPI_Request));
+  MPI_Request *recv_reqs = NULL;
+
+  if (!A_local || !C_local || !panel[0] || !panel[1] || !send_reqs)
+  {
+    printf("Error al asignar memoria local en proceso %d\n", rank);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  generate_block(A_local, n, seed, MATRIX_A, n, block_offset(n, size, rank),
+                 rows_local, 0, n, GEMM_B_NORMAL);
+
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+
+  // Filas por trozo entre llamadas a MPI_Test: un bloque mc por hilo
+  int chunk = tiles.mc;
+#ifdef _OPENMP
+  chunk *= omp_get_max_threads();
+#endif
+  PerfPhase *perf = perfctr_phase_create("local_gemm pipeline");
+
+  double start_time = MPI_Wtime();
+
+  // El proceso 0 deja preparadas las recepciones de todos los trozos de C
+  if (rank == 0)
+  {
+    recv_reqs = (MPI_Request *)malloc((size_t)size * num_panels * sizeof(MPI_Request));
+    for (int r = 0; r < size; r++)
+    {
+      for (int p = 0; p < num_panels; p++)
+      {
+        int j0 = p * w;
+        int wp = (j0 + w < n) ? w : n - j0;
+        MPI_Datatype piece;
+        MPI_Type_vector(block_size(n, size, r), wp, n, MPI_INT32_T, &piece);
+        MPI_Type_commit(&piece);
+        MPI_Irecv(C + (size_t)block_offset(n, size, r) * n + j0, 1, piece,
+                  r, p, MPI_COMM_WORLD, &recv_reqs[r * num_panels + p]);
+        MPI_Type_free(&piece);
+      }
+    }
+  }
+
+  MPI_Request bcast_req[2];
+
+  for (int p = 0; p < num_panels; p++)
+  {
+    // Lanzar la difusión de los paneles p (solo la primera vez) y p + 1
+    for (int q = (p == 0) ? 0 : p + 1; q <= p + 1 && q < num_panels; q++)
+    {
+      int wq = (q * w + w < n) ? w : n - q * w;
+      if (rank == 0)
+        pack_panel(B, n, q * w, wq, panel[q % 2]);
+      MPI_Ibcast(panel[q % 2], n * wq, MPI_INT32_T, 0, MPI_COMM_WORLD,
+                 &bcast_req[q % 2]);
+    }
+
+    MPI_Wait(&bcast_req[p % 2], MPI_STATUS_IGNORE);
+
+    int j0 = p * w;
+    int wp = (j0 + w < n) ? w : n - j0;
+    int next_pending = (p + 1 < num_panels);
+
+    // Calcular por bloques de filas, dando a MPI la ocasión de avanzar la
+    // difusión siguiente entre bloque y bloque
+    for (int i0 = 0; i0 < rows_local; i0 += chunk)
+    {
+      int mb = (i0 + chunk < rows_local) ? chunk : rows_local - i0;
+      local_gemm(mb, wp, n, A_local + (size_t)i0 * n, n, panel[p % 2], n,
+                 C_local + (size_t)i0 * n + j0, n, &tiles, perf);
+      if (next_pending)
+      {
+        int done;
+        MPI_Test(&bcast_req[(p + 1) % 2], &done, MPI_STATUS_IGNORE);
+        next_pending = !done;
+      }
+    }
+
+    MPI_Datatype piece;
+    MPI_Type_vector(rows_local, wp, n, MPI_INT32_T, &piece);
+    MPI_Type_commit(&piece);
+    MPI_Isend(C_local + j0, 1, piece, 0, p, MPI_COMM_WORLD, &send_reqs[p]);
+    MPI_Type_free(&piece);
+  }
+
+  MPI_Waitall(num_panels, send_reqs, MPI_STATUSES_IGNORE);
+  if (rank == 0)
+    MPI_Waitall(size * num_panels, recv_reqs, MPI_STATUSES_IGNORE);
+
+  double end_time = MPI_Wtime();
+  perfctr_phase_finish(perf, rank);
+
+  if (rank == 0)
+  {
+    if (n <= 5)
+    {
+      print_inputs(n, seed);
+      print_matrix("C", C, n);
+    }
+
+    printf("Tiempo de multiplicacion (MPI pipeline con %d procesos): %.6f segundos\n",
+           size, end_time - start_time);
+    printf("Paneles de B: %d de %d columnas\n", num_panels, w);
+  }
+
+  if (correcto)
+    *correcto = verify_distributed(C_local, n, block_offset(n, size, rank),
+                                   rows_local, 0, n, n, seed, rank, size);
+
+  free(A_local);
+  free(C_local);
+  free(panel[0]);
+  free(panel[1]);
+  free(send_reqs);
+
+  if (rank == 0)
+  {
+    free(B);
+    free(C);
+    free(recv_reqs);
+  }
+
+  return end_time - start_time;
+}
+
+int main(int argc, char *argv[])
+{
+  int rank, size, provided;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+  int verify = verify_requested(&argc, argv);
+  int correcto = 1;
+  int *verificar = verify ? &correcto : NULL;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  uint64_t seed;
+  if (!seed_requested(&argc, argv, &seed))
+  {
+    if (rank == 0)
+      printf("La semilla de --seed debe ser un entero sin signo\n");
+    MPI_Finalize();
+    return 1;
+  }
+
+  if (argc < PRIMER_OPCIONAL || argc > PRIMER_OPCIONAL + 2)
+  {
+    if (rank == 0)
+      printf("Uso: mpirun -np <procesos> %s " USO_ARGS "\n", argv[0]);
+    MPI_Finalize();
+    return 1;
+  }
+
+  int n = atoi(argv[1]);
+  int num_threads = (PRIMER_OPCIONAL > 2) ? atoi(argv[2]) : 1;
+  const char *mode = (argc > PRIMER_OPCIONAL) ? argv[PRIMER_OPCIONAL] : "filas";
+  int panel_width = (argc > PRIMER_OPCIONAL + 1) ? atoi(argv[PRIMER_OPCIONAL + 1])
+                                                 : ANCHO_PANEL;
+  if (n <= 0 || num_threads <= 0 || panel_width <= 0)
+  {
+    if (rank == 0)
+      printf("El tamaño, número de hilos y ancho de panel deben ser positivos\n");
+    MPI_Finalize();
+    return 1;
+  }
+
+  // Bloques y orden del kernel local del perfil de ajuste de cada máquina
+  // (cada proceso lee el de su nodo)
+  tune_select(n, rank == 0);
+
+#ifdef _OPENMP
+  if (provided < MPI_THREAD_FUNNELED && rank == 0)
+    printf("Aviso: MPI no garantiza MPI_THREAD_FUNNELED\n");
+  omp_set_num_threads(num_threads);
+#endif
+
+  // Todos los procesos generan sus partes con la semilla del proceso 0
+  // (sin --seed cada uno tiene la hora a la que arrancó)
+  MPI_Bcast(&seed, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+  double elapsed;
+  if (strcmp(mode, "filas") == 0)
+    elapsed = run_rows(n, rank, size, seed, verificar);
+  else if (strcmp(mode, "summa") == 0)
+    elapsed = run_summa(n, rank, size, seed, verificar);
+  else if (strcmp(mode, "cannon") == 0)
+    elapsed = run_cannon(n, rank, size, seed, verificar);
+  else if (strcmp(mode, "pipeline") == 0)
+    elapsed = run_pipeline(n, rank, size, panel_width, seed, verificar);
+  else
+  {
+    if (rank == 0)
+      printf("Modo desconocido: %s\n", mode);
+    elapsed = -1.0;
+  }
+
+#ifdef _OPENMP
+  if (rank == 0 && elapsed >= 0.0)
+    printf("Hilos OpenMP por proceso: %d\n", num_threads);
+#endif
+
   MPI_Finalize();
-  return 0;
-}
\ No newline at end of file
+  return (elapsed < 0.0 || !correcto) ? 1 : 0;
+}
@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdint.h>
+#include <omp.h>
+#include "gemm.h"
+#include "rng.h"
+#include "verify.h"
+#include "tune.h"
+
+// Ajuste empírico del kernel para un tamaño n en la máquina actual: busca
+// por coordenadas (un parámetro cada vez, manteniendo los demás) los
+// tamaños de bloque, el orden de los bucles, la planificación de OpenMP y
+// el número de hilos, repitiendo las pasadas mientras algo mejore, y
+// guarda el ganador en el perfil de la máquina (ver tune.h)
+
+#define MAX_PASADAS 3
+#define REPETICIONES 3
+
+// Una mejora por debajo de este margen se toma como ruido
+#define MARGEN 0.99
+
+enum { P_MC, P_NC, P_KC, P_ORDEN, P_SCHEDULE, P_HILOS, NUM_PARAMETROS };
+
+static const int valores_mc[] = { 32, 64, 96, 128, 192, 256 };
+static const int valores_nc[] = { 128, 256, 512, 1024, 2048, 4096 };
+static const int valores_kc[] = { 64, 128, 256, 384, 512, 768 };
+
+#define NUM_VALORES(v) ((int)(sizeof(v) / sizeof((v)[0])))
+
+typedef struct
+{
+  TileConfig tiles;
+  TuneSchedule schedule;
+  int threads;
+} Candidato;
+
+// C = A * B por bloques de filas de mc, repartidos con la planificación
+// del candidato (como matrix-mult-omp-reduction y sections)
+void multiply_matrices(const int32_t *A, const int32_t *Bt, int32_t *C, int n,
+                       const Candidato *c)
+{
+  int bloques = gemm_num_blocks(n, c->tiles.mc);
+
+  omp_set_num_threads(c->threads);
+  tune_set_omp_schedule(c->schedule);
+
+  #pragma omp parallel for schedule(runtime)
+  for (int b = 0; b < bloques; b++) {
+    int inicio = b * c->tiles.mc;
+    int fin = (inicio + c->tiles.mc < n) ? inicio + c->tiles.mc : n;
+    hpc_gemm_i32_tiles(GEMM_NO_TRANS, GEMM_TRANS, fin - inicio, n, n, 1,
+                       A + (size_t)inicio * n, n, Bt, n, 0,
+                       C + (size_t)inicio * n, n, &c->tiles);
+  }
+}
+
+// Mejor tiempo de 'reps' ejecuciones, tras una de calentamiento
+double measure(const int32_t *A, const int32_t *Bt, int32_t *C, int n,
+               const Candidato *c, int reps)
+{
+  double mejor = 0.0;
+
+  multiply_matrices(A, Bt, C, n, c);
+  for (int r = 0; r < reps; r++)
+  {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    multiply_matrices(A, Bt, C, n, c);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    if (r == 0 || t < mejor)
+      mejor = t;
+  }
+  return mejor;
+}
+
+double gops(int n, double seconds)
+{
+  return (seconds > 0) ? 2.0 * n * n * (double)n / seconds / 1e9 : 0.0;
+}
+
+void print_candidate(const Candidato *c)
+{
+  printf("mc=%d nc=%d kc=%d orden=%s schedule=%s hilos=%d", c->tiles.mc,
+         c->tiles.nc, c->tiles.kc, gemm_order_name(c->tiles.order),
+         tune_schedule_name(c->schedule), c->threads);
+}
+
+// Valores posibles del parámetro p; devuelve cuántos hay
+int parameter_values(int p, int max_threads, int *valores)
+{
+  int count = 0;
+  switch (p)
+  {
+    case P_MC:
+      memcpy(valores, valores_mc, sizeof(valores_mc));
+      return NUM_VALORES(valores_mc);
+    case P_NC:
+      memcpy(valores, valores_nc, sizeof(valores_nc));
+      return NUM_VALORES(valores_nc);
+    case P_KC:
+      memcpy(valores, valores_kc, sizeof(valores_kc));
+      return NUM_VALORES(valores_kc);
+    case P_ORDEN:
+      valores[0] = GEMM_ORDER_JKI;
+      valores[1] = GEMM_ORDER_IKJ;
+      return 2;
+    case P_SCHEDULE:
+      valores[0] = TUNE_SCHED_STATIC;
+      valores[1] = TUNE_SCHED_DYNAMIC;
+      valores[2] = TUNE_SCHED_GUIDED;
+      return 3;
+    default:
+      // Potencias de dos y el máximo
+      for (int t = 1; t < max_threads; t *= 2)
+        valores[count++] = t;
+      valores[count++] = max_threads;
+      return count;
+  }
+}
+
+// El candidato c con el parámetro p cambiado a v
+Candidato with_parameter(const Candidato *c, int p, int v)
+{
+  Candidato r = *c;
+  switch (p)
+  {
+    case P_MC: r.tiles.mc = v; break;
+    case P_NC: r.tiles.nc = v; break;
+    case P_KC: r.tiles.kc = v; break;
+    case P_ORDEN: r.tiles.order = (GemmLoopOrder)v; break;
+    case P_SCHEDULE: r.schedule = (TuneSchedule)v; break;
+    default: r.threads = v; break;
+  }
+  return r;
+}
+
+// Dos candidatos hacen lo mismo con este n: un bloque mayor que la matriz
+// equivale a la matriz entera
+int same_effective(const Candidato *a, const Candidato *b, int n)
+{
+  #define EFECTIVO(x) ((x) < n ? (x) : n)
+  return EFECTIVO(a->tiles.mc) == EFECTIVO(b->tiles.mc) &&
+         EFECTIVO(a->tiles.nc) == EFECTIVO(b->tiles.nc) &&
+         EFECTIVO(a->tiles.kc) == EFECTIVO(b->tiles.kc) &&
+         a->tiles.order == b->tiles.order && a->schedule == b->schedule &&
+         a->threads == b->threads;
+  #undef EFECTIVO
+}
+
+int main(int argc, char *argv[])
+{
+  int verify = verify_requested(&argc, argv);
+  uint64_t seed;
+  if (!seed_requested(&argc, argv, &seed))
+  {
+    printf("La semilla de --seed debe ser un entero sin signo\n");
+    return 1;
+  }
+
+  if (argc < 2 || argc > 3)
+  {
+    printf("Uso: %s <tamano_matriz> [max_hilos] [--verify] [--seed N]\n", argv[0]);
+    return 1;
+  }
+
+  int n = atoi(argv[1]);
+  int max_threads = (argc > 2) ? atoi(argv[2]) : omp_get_num_procs();
+
+  if (n <= 0 || max_threads <= 0)
+  {
+    printf("El tamaño y número de hilos deben ser positivos\n");
+    return 1;
+  }
+
+  const char *value = getenv("GEMM_TUNE_REPS");
+  int reps = (value != NULL && atoi(value) > 0) ? atoi(value) : REPETICIONES;
+
+  // Se parte del perfil que haya (o de los valores por defecto)
+  tune_select(n, 1);
+  Candidato mejor;
+  gemm_tiles_init(&mejor.tiles);
+  mejor.schedule = tune_schedule(TUNE_SCHED_DYNAMIC);
+  mejor.threads = tune_threads(0, max_threads);
+  if (mejor.threads > max_threads)
+    mejor.threads = max_threads;
+
+  int32_t *A = (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *Bt = (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *C = (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+
+  if (!A || !Bt || !C)
+  {
+    printf("Error al asignar memoria\n");
+    return 1;
+  }
+
+  generate_matrix_philox(A, n, seed, MATRIX_A, GEMM_B_NORMAL);
+  generate_matrix_philox(Bt, n, seed, MATRIX_B, GEMM_B_TRANSPOSED);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  double mejor_t = measure(A, Bt, C, n, &mejor, reps);
+  int probados = 1;
+  printf("Inicial: ");
+  print_candidate(&mejor);
+  printf(": %.3f GOP/s\n", gops(n, mejor_t));
+
+  int valores[64];
+  for (int pasada = 0; pasada < MAX_PASADAS; pasada++)
+  {
+    int cambios = 0;
+    for (int p = 0; p < NUM_PARAMETROS; p++)
+    {
+      int count = parameter_values(p, max_threads, valores);
+      Candidato base = mejor;
+      for (int i = 0; i < count; i++)
+      {
+        Candidato c = with_parameter(&base, p, valores[i]);
+        if (same_effective(&c, &base, n))
+          continue;
+
+        double t = measure(A, Bt, C, n, &c, reps);
+        probados++;
+        if (t < mejor_t * MARGEN)
+        {
+          mejor = c;
+          mejor_t = t;
+          cambios++;
+          printf("Mejora: ");
+          print_candidate(&mejor);
+          printf(": %.3f GOP/s\n", gops(n, mejor_t));
+        }
+      }
+    }
+    if (cambios == 0)
+      break;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double elapsed = (end.tv_sec - start.tv_sec) +
+                   (end.tv_nsec - start.tv_nsec) / 1e9;
+
+  printf("Mejor para n=%d: ", n);
+  print_candidate(&mejor);
+  printf(": %.3f GOP/s (%.6f segundos)\n", gops(n, mejor_t), mejor_t);
+  printf("Tiempo de ajuste: %.6f segundos, %d configuraciones probadas\n",
+         elapsed, probados);
+
+  TuneEntry entry;
+  entry.n = n;
+  entry.tiles = mejor.tiles;
+  entry.schedule = mejor.schedule;
+  entry.threads = mejor.threads;
+  entry.gops = gops(n, mejor_t);
+
+  int guardado = 1;
+  char path[4096];
+  if (!tune_profile_path(path, sizeof(path)))
+  {
+    printf("Sin fichero de perfil (GEMM_PROFILE=none), no se guarda\n");
+  }
+  else if (tune_save(path, &entry))
+  {
+    printf("Perfil guardado en %s\n", path);
+  }
+  else
+  {
+    printf("Error al guardar el perfil en %s\n", path);
+    guardado = 0;
+  }
+
+  // Comprobar C = A * B con Freivalds (--verify) con la configuración
+  // ganadora
+  int correcto = 1;
+  if (verify)
+  {
+    multiply_matrices(A, Bt, C, n, &mejor);
+    correcto = freivalds_verify(A, Bt, GEMM_INT32, GEMM_B_TRANSPOSED, C, n,
+                                seed);
+  }
+
+  free(A);
+  free(Bt);
+  free(C);
+
+  return (correcto && guardado) ? 0 : 1;
+}
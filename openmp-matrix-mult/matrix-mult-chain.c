@@ -0,0 +1,376 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdint.h>
+#include <omp.h>
+#include "gemm.h"
+#include "rng.h"
+#include "verify.h"
+#include "tune.h"
+#include "chain.h"
+
+// Potencias A^k por cuadrados sucesivos y cadenas A1 * A2 * ... * Am en el
+// orden óptimo, repetidas varias veces sobre el mismo espacio de trabajo
+// (chain.h): solo la primera repetición reserva buffers
+
+#define MAX_MATRICES 64
+
+// Matriz rows x cols por filas con enteros aleatorios (flujo id del
+// generador), repartiendo las filas entre los hilos
+void generate_rect(int32_t *M, int rows, int cols, uint64_t seed, int id)
+{
+  #pragma omp parallel for schedule(static)
+  for (int i = 0; i < rows; i++) {
+    generate_block(M + (size_t)i * cols, cols, seed, id, cols, i, 1, 0, cols,
+                   GEMM_B_NORMAL);
+  }
+}
+
+// "d0,d1,...,dm" en dims; devuelve m, o 0 si la lista no es válida
+int parse_dims(const char *text, int *dims)
+{
+  int count = 0;
+  const char *p = text;
+  while (count <= MAX_MATRICES)
+  {
+    char *end;
+    long d = strtol(p, &end, 10);
+    if (end == p || d <= 0 || d > 1 << 20)
+      return 0;
+    dims[count++] = (int)d;
+    if (*end == '\0')
+      break;
+    if (*end != ',')
+      return 0;
+    p = end + 1;
+  }
+  return (count >= 2 && count <= MAX_MATRICES + 1) ? count - 1 : 0;
+}
+
+// Paréntesis del orden de split para las matrices i .. j
+void print_order(const int *split, int m, int i, int j)
+{
+  if (i == j)
+  {
+    printf("A%d", i + 1);
+    return;
+  }
+  int k = split[i * m + j];
+  printf("(");
+  print_order(split, m, i, k);
+  printf(" ");
+  print_order(split, m, k + 1, j);
+  printf(")");
+}
+
+// Freivalds para C = mats[0] * ... * mats[m - 1] (m = 0 es la identidad):
+// se aplican las matrices de derecha a izquierda a los vectores R, en
+// O(k * sum dims[i] * dims[i + 1]), y se compara con C * R
+int verify_chain(const int32_t *const *mats, const int *dims, int m,
+                 const int32_t *C, uint64_t seed)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  int k = verify_rounds();
+  int max_dim = 0;
+  for (int i = 0; i <= m; i++)
+    max_dim = (dims[i] > max_dim) ? dims[i] : max_dim;
+
+  size_t size = (size_t)max_dim * k * sizeof(uint32_t);
+  uint32_t *R = malloc(size);
+  uint32_t *y = malloc(size);
+  uint32_t *t = malloc(size);
+  uint32_t *w = malloc(size);
+  if (!R || !y || !t || !w)
+  {
+    printf("Error al asignar memoria para la verificacion\n");
+    free(R);
+    free(y);
+    free(t);
+    free(w);
+    return 0;
+  }
+
+  freivalds_vectors(R, dims[m], k, seed);
+  memcpy(y, R, (size_t)dims[m] * k * sizeof(uint32_t));
+  for (int i = m - 1; i >= 0; i--)
+  {
+    freivalds_apply(mats[i], GEMM_INT32, dims[i + 1], dims[i], dims[i + 1],
+                    y, k, t);
+    uint32_t *swap = y;
+    y = t;
+    t = swap;
+  }
+  freivalds_apply(C, GEMM_INT32, dims[m], dims[0], dims[m], R, k, w);
+
+  int wrong = 0;
+  for (int i = 0; i < dims[0]; i++) {
+    wrong += memcmp(y + (size_t)i * k, w + (size_t)i * k,
+                    (size_t)k * sizeof(uint32_t)) != 0;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  verify_report(wrong, k, (end.tv_sec - start.tv_sec) +
+                          (end.tv_nsec - start.tv_nsec) / 1e9);
+
+  free(R);
+  free(y);
+  free(t);
+  free(w);
+  return wrong == 0;
+}
+
+// Comprobación de la potencia paso a paso (ChainCheck): cada producto
+// Z = X * Y de los cuadrados sucesivos se comprueba con Freivalds,
+// X * (Y * R) == Z * R, en O(k n²). En total O(k n² log2(exponente)) sin
+// rehacer ningún producto ni guardar los intermedios
+typedef struct
+{
+  uint32_t *R, *y, *z, *w;
+  int k;
+  int wrong;      // filas incorrectas, sumando todos los productos
+  double seconds;
+} PowerCheck;
+
+int power_check_init(PowerCheck *pc, int n, uint64_t seed)
+{
+  pc->k = verify_rounds();
+  size_t size = (size_t)n * pc->k * sizeof(uint32_t);
+  pc->R = malloc(size);
+  pc->y = malloc(size);
+  pc->z = malloc(size);
+  pc->w = malloc(size);
+  pc->wrong = 0;
+  pc->seconds = 0.0;
+  if (!pc->R || !pc->y || !pc->z || !pc->w)
+    return 0;
+  freivalds_vectors(pc->R, n, pc->k, seed);
+  return 1;
+}
+
+void power_check_free(PowerCheck *pc)
+{
+  free(pc->R);
+  free(pc->y);
+  free(pc->z);
+  free(pc->w);
+}
+
+void check_product(const int32_t *X, const int32_t *Y, const int32_t *Z, int n,
+                   void *arg)
+{
+  PowerCheck *pc = (PowerCheck *)arg;
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  int k = pc->k;
+  freivalds_apply(Y, GEMM_INT32, n, n, n, pc->R, k, pc->y);
+  freivalds_apply(X, GEMM_INT32, n, n, n, pc->y, k, pc->z);
+  freivalds_apply(Z, GEMM_INT32, n, n, n, pc->R, k, pc->w);
+  for (int i = 0; i < n; i++) {
+    pc->wrong += memcmp(pc->z + (size_t)i * k, pc->w + (size_t)i * k,
+                        (size_t)k * sizeof(uint32_t)) != 0;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  pc->seconds += (end.tv_sec - start.tv_sec) +
+                 (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+void usage(const char *prog)
+{
+  printf("Uso: %s potencia <tamano_matriz> <exponente> <num_hilos|0> "
+         "[repeticiones] [--verify] [--seed N]\n", prog);
+  printf("     %s cadena <d0,d1,...,dm> <num_hilos|0> [repeticiones] "
+         "[--verify] [--seed N]\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+  int verify = verify_requested(&argc, argv);
+  uint64_t seed;
+  if (!seed_requested(&argc, argv, &seed))
+  {
+    printf("La semilla de --seed debe ser un entero sin signo\n");
+    return 1;
+  }
+
+  int power = (argc > 1 && strcmp(argv[1], "potencia") == 0);
+  int chain = (argc > 1 && strcmp(argv[1], "cadena") == 0);
+  int first_opt = power ? 5 : 4;
+  if ((!power && !chain) || argc < first_opt || argc > first_opt + 1)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  // Dimensiones de la cadena; en potencia solo está A (n x n)
+  int dims[MAX_MATRICES + 1];
+  int m, n = 0;
+  long exponent = 0;
+  if (power)
+  {
+    n = atoi(argv[2]);
+    exponent = atol(argv[3]);
+    m = 1;
+    dims[0] = dims[1] = n;
+  }
+  else
+  {
+    m = parse_dims(argv[2], dims);
+    if (m == 0)
+    {
+      printf("La cadena debe ser una lista d0,d1,...,dm de entre 2 y %d "
+             "tamaños positivos\n", MAX_MATRICES + 1);
+      return 1;
+    }
+  }
+  int num_threads = atoi(argv[first_opt - 1]);
+  int reps = (argc > first_opt) ? atoi(argv[first_opt]) : 1;
+
+  if ((power && (n <= 0 || exponent < 0 || exponent > 1L << 30)) ||
+      num_threads < 0 || reps <= 0)
+  {
+    printf("El tamaño y las repeticiones deben ser positivos, el exponente "
+           "y el número de hilos no negativos\n");
+    return 1;
+  }
+
+  // Bloques del perfil de ajuste para el mayor de los tamaños
+  int max_dim = 0;
+  for (int i = 0; i <= m; i++)
+    max_dim = (dims[i] > max_dim) ? dims[i] : max_dim;
+  tune_select(max_dim, 1);
+  num_threads = tune_threads(num_threads, omp_get_num_procs());
+  omp_set_num_threads(num_threads);
+
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+
+  // Operandos: A_i es dims[i] x dims[i + 1] y usa el flujo i del generador
+  int32_t *mats[MAX_MATRICES];
+  for (int i = 0; i < m; i++)
+  {
+    mats[i] = (int32_t *)malloc((size_t)dims[i] * dims[i + 1] *
+                                sizeof(int32_t));
+    if (!mats[i])
+    {
+      printf("Error al asignar memoria\n");
+      return 1;
+    }
+    generate_rect(mats[i], dims[i], dims[i + 1], seed, i);
+  }
+  int32_t *C = (int32_t *)malloc((size_t)dims[0] * dims[m] * sizeof(int32_t));
+  int *split = (int *)malloc((size_t)m * m * sizeof(int));
+  if (!C || !split)
+  {
+    printf("Error al asignar memoria\n");
+    return 1;
+  }
+
+  int products;
+  int64_t optimal = 0;
+  if (power)
+  {
+    products = chain_power_products((unsigned)exponent);
+  }
+  else
+  {
+    optimal = chain_order(dims, m, split);
+    if (optimal < 0)
+    {
+      printf("Error al asignar memoria\n");
+      return 1;
+    }
+    products = m - 1;
+  }
+
+  // Con --verify, en potencia se comprueba cada producto de la última
+  // repetición (sin contar su tiempo). Con exponente 0 o 1 no hay productos
+  // y C se comprueba al final como en las cadenas
+  PowerCheck pc = { 0 };
+  int check_steps = verify && power && exponent > 1;
+  if (check_steps && !power_check_init(&pc, n, seed))
+  {
+    printf("Error al asignar memoria para la verificacion\n");
+    return 1;
+  }
+
+  // La primera repetición reserva y toca los buffers; las demás los
+  // reutilizan
+  ChainWorkspace ws;
+  chain_workspace_init(&ws);
+  double first = 0.0, rest = 0.0;
+  int ok = 1;
+  for (int r = 0; r < reps && ok; r++)
+  {
+    ChainCheck check = (check_steps && r == reps - 1) ? check_product : NULL;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (power)
+      ok = chain_power(mats[0], n, (unsigned)exponent, C, &ws, &tiles, check,
+                       &pc);
+    else
+      ok = chain_product((const int32_t *const *)mats, dims, m, split, C,
+                         &ws, &tiles);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double t = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    if (check)
+      t -= pc.seconds;
+    if (r == 0)
+      first = t;
+    else
+      rest += t;
+  }
+  if (!ok)
+  {
+    printf("Error al asignar memoria para los resultados intermedios\n");
+    return 1;
+  }
+
+  if (power)
+  {
+    printf("A^%ld con A de %dx%d: %d productos\n", exponent, n, n, products);
+  }
+  else
+  {
+    printf("Cadena de %d matrices, orden ", m);
+    print_order(split, m, 0, m - 1);
+    printf(": %lld multiplicaciones-suma (de izquierda a derecha, %lld)\n",
+           (long long)optimal, (long long)chain_cost_left(dims, m));
+  }
+  printf("Tiempo de la primera repeticion con %d hilos: %.6f segundos\n",
+         num_threads, first);
+  if (reps > 1)
+    printf("Tiempo medio de las %d siguientes: %.6f segundos\n", reps - 1,
+           rest / (reps - 1));
+  printf("Buffers intermedios: %d reservas de %zu elementos en %d "
+         "repeticiones\n", ws.allocations, ws.capacity, reps);
+
+  // Comprobar C con Freivalds (--verify)
+  int correcto = 1;
+  if (check_steps)
+  {
+    printf("Productos de la potencia comprobados: %d\n", products);
+    verify_report(pc.wrong, pc.k, pc.seconds);
+    correcto = pc.wrong == 0;
+    power_check_free(&pc);
+  }
+  else if (verify)
+  {
+    correcto = verify_chain((const int32_t *const *)mats, dims,
+                            power ? (int)exponent : m, C, seed);
+  }
+
+  chain_workspace_free(&ws);
+  for (int i = 0; i < m; i++)
+    free(mats[i]);
+  free(C);
+  free(split);
+
+  return correcto ? 0 : 1;
+}
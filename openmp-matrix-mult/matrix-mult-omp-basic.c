@@ -3,55 +3,155 @@
 #include <time.h>
 #include <stdint.h>
 #include <omp.h>
+#include "gemm.h"
+#include "rng.h"
+#include "transpose.h"
+#include "matfile.h"
+#include "verify.h"
+#include "tune.h"
+#include "ooc.h"
+#include "sparse.h"
+#include "placement.h"
+#include "perfctr.h"
 
 // Generar una matriz cuadrada NxN con enteros aleatorios
-void generate_matrix(int32_t *matrix, int n)
+void generate_matrix(int32_t *matrix, int n, uint64_t seed, int id,
+                     GemmLayout layout)
 {
-  for (int i = 0; i < n * n; i++) {
-    matrix[i] = rand() % 100;
+  generate_matrix_philox(matrix, n, seed, id, layout);
+}
+
+// Primer contacto de A y C con el mismo reparto estático de bloques que
+// multiply_matrices, de modo que cada hilo calcula sobre páginas de su nodo
+void first_touch(int32_t *A, int32_t *C, int n, uint64_t seed)
+{
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+  int bloques_i = gemm_num_blocks(n, tiles.mc);
+  int bloques_j = gemm_num_blocks(n, tiles.nc);
+
+  #pragma omp parallel for collapse(2) schedule(static)
+  for (int bi = 0; bi < bloques_i; bi++) {
+    for (int bj = 0; bj < bloques_j; bj++) {
+      int i0 = bi * tiles.mc;
+      int j0 = bj * tiles.nc;
+      int i1 = (i0 + tiles.mc < n) ? i0 + tiles.mc : n;
+      int j1 = (j0 + tiles.nc < n) ? j0 + tiles.nc : n;
+      first_touch_block(A, C, n, seed, i0, i1, j0, j1);
+    }
   }
 }
 
-// Multiplicar matrices cuadradas: C = A * B (B transpuesta)
-void multiply_matrices(int32_t *A, int32_t *B, int32_t *C, int n, int num_threads)
+// Multiplicar matrices cuadradas: C = A * B (B transpuesta, A y B con
+// elementos de tipo elem)
+void multiply_matrices(const void *A, const void *B, int32_t **B_nodes,
+                       GemmElem elem, int32_t *C, int n, int num_threads,
+                       const Topology *topo)
 {
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+  int bloques_i = gemm_num_blocks(n, tiles.mc);
+  int bloques_j = gemm_num_blocks(n, tiles.nc);
+  PerfPhase *perf = perfctr_phase_create("multiply_matrices");
+
   omp_set_num_threads(num_threads);
-  
-  #pragma omp parallel for collapse(2) schedule(static)
-  for (int i = 0; i < n; i++) {
-    for (int j = 0; j < n; j++) {
-      int32_t sum = 0;
-      for (int k = 0; k < n; k++) {
-        sum += A[i * n + k] * B[j * n + k];
+  // Reparto estático de bloques (o el del perfil de ajuste), salvo con
+  // colocación NUMA, donde cada hilo debe calcular lo que tocó primero
+  if (topo)
+    omp_set_schedule(omp_sched_static, 0);
+  else
+    tune_set_omp_schedule(tune_schedule(TUNE_SCHED_STATIC));
+
+  #pragma omp parallel
+  {
+    perfctr_enter(perf, omp_get_thread_num());
+
+    // Con copias de B por nodo, cada hilo lee la de su nodo
+    const void *B_hilo = B_nodes
+        ? B_nodes[topology_node(topo, omp_get_thread_num(), num_threads)]
+        : B;
+
+    // Cada iteracion calcula un bloque completo de C. Sin barrera al final
+    // del bucle (ya la pone la región) para no contar la espera
+    #pragma omp for collapse(2) schedule(runtime) nowait
+    for (int bi = 0; bi < bloques_i; bi++) {
+      for (int bj = 0; bj < bloques_j; bj++) {
+        int i0 = bi * tiles.mc;
+        int j0 = bj * tiles.nc;
+        int i1 = (i0 + tiles.mc < n) ? i0 + tiles.mc : n;
+        int j1 = (j0 + tiles.nc < n) ? j0 + tiles.nc : n;
+        gemm_block_narrow(A, B_hilo, elem, C, n, GEMM_B_TRANSPOSED, i0, i1,
+                          j0, j1, &tiles);
       }
-      C[i * n + j] = sum;
     }
+
+    perfctr_leave(perf, omp_get_thread_num());
   }
+
+  perfctr_phase_finish(perf, 0);
 }
 
 int main(int argc, char *argv[])
 {
+  int verify = verify_requested(&argc, argv);
+  uint64_t seed;
+  if (!seed_requested(&argc, argv, &seed))
+  {
+    printf("La semilla de --seed debe ser un entero sin signo\n");
+    return 1;
+  }
+
   if (argc != 3)
   {
-    printf("Uso: %s <tamano_matriz> <num_hilos>\n", argv[0]);
+    printf("Uso: %s <tamano_matriz> <num_hilos|0> [--verify] [--seed N]\n", argv[0]);
     return 1;
   }
 
   int n = atoi(argv[1]);
   int num_threads = atoi(argv[2]);
 
-  if (n <= 0 || num_threads <= 0)
+  if (n <= 0 || num_threads < 0)
   {
-    printf("El tamaño y número de hilos deben ser positivos\n");
+    printf("El tamaño debe ser positivo y el número de hilos no negativo\n");
     return 1;
   }
 
-  srand(time(NULL));
+  // Bloques, orden y planificación del perfil de ajuste de la máquina; con
+  // 0 hilos se usan también los del perfil (o todos los procesadores)
+  tune_select(n, 1);
+  num_threads = tune_threads(num_threads, omp_get_num_procs());
+
+  // Fuera de núcleo: A, B y C se quedan en disco y se leen por paneles
+  if (ooc_enabled())
+  {
+    OocStats stats;
+    omp_set_num_threads(num_threads);
+    if (!ooc_run(n, seed, &stats))
+    {
+      return 1;
+    }
+    printf("Tiempo de multiplicacion fuera de nucleo con %d hilos (OpenMP): "
+           "%.6f segundos\n", num_threads, stats.seconds);
+    printf("Espera de E/S: %.6f segundos, %.1f MB leidos\n",
+           stats.io_wait_seconds, stats.bytes_read / 1e6);
+    printf("Paneles de %d filas de A y C y %d filas de B\n",
+           stats.panel_rows, stats.panel_depth);
+    return (!verify || ooc_verify(seed)) ? 0 : 1;
+  }
+
+  // Operandos y resultado en ficheros mapeados si se piden
+  MatFile fa, fb, fc;
+  if (!matfile_operand("GEMM_A_FILE", n, seed, MATRIX_A, &fa) ||
+      !matfile_operand("GEMM_B_FILE", n, seed, MATRIX_B, &fb) ||
+      !matfile_result(n, &fc))
+  {
+    return 1;
+  }
 
   // Reservar memoria dinámica
-  int32_t *A = (int32_t *)malloc(n * n * sizeof(int32_t));
-  int32_t *B = (int32_t *)malloc(n * n * sizeof(int32_t));
-  int32_t *C = (int32_t *)malloc(n * n * sizeof(int32_t));
+  int32_t *A = fa.data ? fa.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *B = fb.data ? fb.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *C = fc.data ? fc.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
 
   if (!A || !B || !C)
   {
@@ -59,15 +159,99 @@ int main(int argc, char *argv[])
     return 1;
   }
 
-  // Llenar matrices con números aleatorios
-  generate_matrix(A, n);
-  generate_matrix(B, n);
+  PlacementMode placement = placement_mode();
+  Topology topo;
+  if (placement != PLACEMENT_NONE && !topology_init(&topo))
+  {
+    printf("No se pudo leer la topologia, se usa GEMM_PLACEMENT=none\n");
+    placement = PLACEMENT_NONE;
+  }
+
+  // Llenar matrices con números aleatorios (en paralelo)
+  omp_set_num_threads(num_threads);
+  int32_t **B_nodes = NULL;
+  if (placement == PLACEMENT_NONE)
+  {
+    if (!fa.data)
+    {
+      generate_matrix(A, n, seed, MATRIX_A, GEMM_B_NORMAL);
+    }
+  }
+  else
+  {
+    placement_bind_omp(&topo, num_threads);
+    first_touch(fa.data ? NULL : A, C, n, seed);
+  }
+  if (!fb.data)
+  {
+    generate_matrix(B, n, seed, MATRIX_B, GEMM_B_NORMAL);
+  }
+
+  // Transponer B una sola vez, en una etapa aparte: todas las versiones
+  // pasan al kernel B[j * n + k]
+  double t_transpose;
+  int32_t *Bt = transpose_stage(B, n, &t_transpose);
+  if (!Bt)
+  {
+    printf("Error al asignar memoria\n");
+    return 1;
+  }
+  matfile_release(&fb, B);
+  B = Bt;
+
+  // Camino disperso: si A o B tienen pocos no nulos se comprimen en CSR o
+  // CSC y se multiplica sin el kernel denso
+  SparsePlan plan;
+  if (!sparse_plan_create(A, B, n, &plan))
+  {
+    printf("Error al asignar memoria\n");
+    return 1;
+  }
+
+  // Modo estrecho: A y B pasan a int8 o int16 si sus valores caben
+  GemmElem elem = GEMM_INT32;
+  void *An = A, *Bn = B;
+  if (gemm_narrow_enabled() && plan.kind == SPARSE_NONE)
+  {
+    elem = gemm_narrow_elem(A, B, (size_t)n * n);
+    if (elem != GEMM_INT32)
+    {
+      An = gemm_narrow_copy(A, (size_t)n * n, elem);
+      Bn = gemm_narrow_copy(B, (size_t)n * n, elem);
+      if (!An || !Bn)
+      {
+        printf("Error al asignar memoria\n");
+        return 1;
+      }
+      matfile_release(&fa, A);
+      free(B);
+    }
+  }
+
+  if (placement == PLACEMENT_REPLICATE && plan.kind == SPARSE_NONE)
+  {
+    B_nodes = replicate_per_node((const int32_t *)Bn,
+                                 ((size_t)n * n * elem + 3) / 4, &topo);
+    if (!B_nodes)
+    {
+      printf("Error al asignar memoria\n");
+      return 1;
+    }
+  }
 
   // Medir tiempo
   struct timespec start, end;
   clock_gettime(CLOCK_MONOTONIC, &start);
 
-  multiply_matrices(A, B, C, n, num_threads);
+  if (plan.kind != SPARSE_NONE)
+  {
+    sparse_multiply(&plan, A, C, n);
+  }
+  else
+  {
+    multiply_matrices(An, Bn, B_nodes, elem, C, n, num_threads,
+                      (placement != PLACEMENT_NONE) ? &topo : NULL);
+  }
 
   clock_gettime(CLOCK_MONOTONIC, &end);
 
@@ -80,7 +264,7 @@ int main(int argc, char *argv[])
     printf("Matriz A:\n");
     for (int i = 0; i < n; i++) {
       for (int j = 0; j < n; j++) {
-        printf("%d ", A[i * n + j]);
+        printf("%d ", gemm_narrow_at(An, elem, i * n + j));
       }
       printf("\n");
     }
@@ -88,7 +272,7 @@ int main(int argc, char *argv[])
     printf("Matriz B:\n");
     for (int i = 0; i < n; i++) {
       for (int j = 0; j < n; j++) {
-        printf("%d ", B[j * n + i]);
+        printf("%d ", gemm_narrow_at(Bn, elem, j * n + i));
       }
       printf("\n");
     }
@@ -104,11 +288,47 @@ int main(int argc, char *argv[])
 
   printf("Tiempo de multiplicacion con %d hilos (OpenMP): %.6f segundos\n",
          num_threads, elapsed);
+  printf("Tiempo de transposicion de B: %.6f segundos\n", t_transpose);
+  if (plan.kind != SPARSE_NONE)
+  {
+    printf("Multiplicacion dispersa: %s (densidad de A %.3f, de B %.3f)\n",
+           sparse_kind_name(plan.kind), plan.density_a, plan.density_b);
+    printf("Tiempo de muestreo y compresion: %.6f segundos\n", plan.seconds);
+  }
+  if (gemm_narrow_enabled())
+  {
+    printf("Elementos de A y B de %d bytes\n", (int)elem);
+  }
+
+  if (placement != PLACEMENT_NONE)
+  {
+    printf("Colocacion %s con %d nodos NUMA\n", placement_name(placement),
+           topo.num_nodes);
+    free_replicas(B_nodes, &topo);
+    topology_free(&topo);
+  }
+
+  // Comprobar C = A * B con Freivalds (--verify)
+  int correcto = !verify || freivalds_verify(An, Bn, elem,
+                                             GEMM_B_TRANSPOSED, C, n, seed);
 
   // Liberar memoria
-  free(A);
-  free(B);
-  free(C);
+  sparse_plan_free(&plan);
+  if (elem == GEMM_INT32)
+  {
+    matfile_release(&fa, A);
+    free(B);
+  }
+  else
+  {
+    free(An);
+    free(Bn);
+  }
+  if (!matfile_release(&fc, C))
+  {
+    printf("Error al escribir C\n");
+    return 1;
+  }
 
-  return 0;
+  return correcto ? 0 : 1;
 }
\ No newline at end of file
@@ -3,56 +3,146 @@
 #include <time.h>
 #include <stdint.h>
 #include <omp.h>
+#include "gemm.h"
+#include "rng.h"
+#include "transpose.h"
+#include "matfile.h"
+#include "verify.h"
+#include "tune.h"
+#include "placement.h"
+#include "perfctr.h"
 
 // Generar una matriz cuadrada NxN con enteros aleatorios
-void generate_matrix(int32_t *matrix, int n)
+void generate_matrix(int32_t *matrix, int n, uint64_t seed, int id,
+                     GemmLayout layout)
 {
-  for (int i = 0; i < n * n; i++) {
-    matrix[i] = rand() % 100;
+  generate_matrix_philox(matrix, n, seed, id, layout);
+}
+
+// Generar A y B a la vez con todo el equipo: un solo bucle reparte entre
+// los hilos las franjas de filas de las dos matrices (con una sección por
+// matriz solo trabajaban dos hilos). NULL si esa matriz ya está
+void generate_operands(int32_t *A, int32_t *B, int n, uint64_t seed)
+{
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+  int bloques = gemm_num_blocks(n, tiles.mc);
+
+  #pragma omp parallel for schedule(static)
+  for (int t = 0; t < 2 * bloques; t++) {
+    int32_t *M = (t < bloques) ? A : B;
+    int inicio = (t % bloques) * tiles.mc;
+    int fin = (inicio + tiles.mc < n) ? inicio + tiles.mc : n;
+    if (M)
+      generate_block(M + (size_t)inicio * n, n, seed,
+                     (t < bloques) ? MATRIX_A : MATRIX_B, n, inicio,
+                     fin - inicio, 0, n, GEMM_B_NORMAL);
+  }
+}
+
+// Primer contacto de A y C por bloques de filas con reparto estático, el
+// mismo que usa multiply_matrices cuando hay colocación NUMA
+void first_touch(int32_t *A, int32_t *C, int n, uint64_t seed)
+{
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+  int bloques = gemm_num_blocks(n, tiles.mc);
+
+  #pragma omp parallel for schedule(static)
+  for (int b = 0; b < bloques; b++) {
+    int inicio = b * tiles.mc;
+    int fin = (inicio + tiles.mc < n) ? inicio + tiles.mc : n;
+    first_touch_block(A, C, n, seed, inicio, fin, 0, n);
   }
 }
 
-// Multiplicar matrices usando sections (paraleliza generación y transpuesta)
-void multiply_matrices(int32_t *A, int32_t *B, int32_t *C, int n, int num_threads)
+// Multiplicar matrices por bloques de filas con reparto guiado
+void multiply_matrices(int32_t *A, int32_t *B, int32_t **B_nodes, int32_t *C,
+                       int n, int num_threads, const Topology *topo)
 {
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+  int bloques = gemm_num_blocks(n, tiles.mc);
+  PerfPhase *perf = perfctr_phase_create("multiply_matrices");
+
   omp_set_num_threads(num_threads);
-  
-  // Paralelizar el cálculo por filas
-  #pragma omp parallel for schedule(guided)
-  for (int i = 0; i < n; i++) {
-    for (int j = 0; j < n; j++) {
-      int32_t sum = 0;
-      for (int k = 0; k < n; k++) {
-        sum += A[i * n + k] * B[j * n + k];
-      }
-      C[i * n + j] = sum;
+  // Reparto guiado de bloques de filas (o el del perfil de ajuste), salvo con
+  // colocación NUMA: ahí el estático hace que cada hilo calcule las filas
+  // que tocó primero
+  if (topo)
+    omp_set_schedule(omp_sched_static, 0);
+  else
+    tune_set_omp_schedule(tune_schedule(TUNE_SCHED_GUIDED));
+
+  #pragma omp parallel
+  {
+    perfctr_enter(perf, omp_get_thread_num());
+
+    // Con copias de B por nodo, cada hilo lee la de su nodo
+    const int32_t *B_hilo = B_nodes
+        ? B_nodes[topology_node(topo, omp_get_thread_num(), num_threads)]
+        : B;
+
+    // Sin barrera al final del bucle (ya la pone la región) para no contar
+    // la espera
+    #pragma omp for schedule(runtime) nowait
+    for (int b = 0; b < bloques; b++) {
+      int inicio = b * tiles.mc;
+      int fin = (inicio + tiles.mc < n) ? inicio + tiles.mc : n;
+      hpc_gemm_i32_tiles(GEMM_NO_TRANS, GEMM_TRANS, fin - inicio, n, n, 1,
+                         A + (size_t)inicio * n, n, B_hilo, n, 0,
+                         C + (size_t)inicio * n, n, &tiles);
     }
+
+    perfctr_leave(perf, omp_get_thread_num());
   }
+
+  perfctr_phase_finish(perf, 0);
 }
 
 int main(int argc, char *argv[])
 {
+  int verify = verify_requested(&argc, argv);
+  uint64_t seed;
+  if (!seed_requested(&argc, argv, &seed))
+  {
+    printf("La semilla de --seed debe ser un entero sin signo\n");
+    return 1;
+  }
+
   if (argc != 3)
   {
-    printf("Uso: %s <tamano_matriz> <num_hilos>\n", argv[0]);
+    printf("Uso: %s <tamano_matriz> <num_hilos|0> [--verify] [--seed N]\n", argv[0]);
     return 1;
   }
 
   int n = atoi(argv[1]);
   int num_threads = atoi(argv[2]);
 
-  if (n <= 0 || num_threads <= 0)
+  if (n <= 0 || num_threads < 0)
   {
-    printf("El tamaño y número de hilos deben ser positivos\n");
+    printf("El tamaño debe ser positivo y el número de hilos no negativo\n");
     return 1;
   }
 
-  srand(time(NULL));
+  // Bloques, orden y planificación del perfil de ajuste de la máquina; con
+  // 0 hilos se usan también los del perfil (o todos los procesadores)
+  tune_select(n, 1);
+  num_threads = tune_threads(num_threads, omp_get_num_procs());
+
+  // Operandos y resultado en ficheros mapeados si se piden
+  MatFile fa, fb, fc;
+  if (!matfile_operand("GEMM_A_FILE", n, seed, MATRIX_A, &fa) ||
+      !matfile_operand("GEMM_B_FILE", n, seed, MATRIX_B, &fb) ||
+      !matfile_result(n, &fc))
+  {
+    return 1;
+  }
 
   // Reservar memoria dinámica
-  int32_t *A = (int32_t *)malloc(n * n * sizeof(int32_t));
-  int32_t *B = (int32_t *)malloc(n * n * sizeof(int32_t));
-  int32_t *C = (int32_t *)malloc(n * n * sizeof(int32_t));
+  int32_t *A = fa.data ? fa.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *B = fb.data ? fb.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *C = fc.data ? fc.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
 
   if (!A || !B || !C)
   {
@@ -60,17 +150,51 @@ int main(int argc, char *argv[])
     return 1;
   }
 
+  PlacementMode placement = placement_mode();
+  Topology topo;
+  if (placement != PLACEMENT_NONE && !topology_init(&topo))
+  {
+    printf("No se pudo leer la topologia, se usa GEMM_PLACEMENT=none\n");
+    placement = PLACEMENT_NONE;
+  }
+
   // Llenar matrices con números aleatorios en paralelo
   omp_set_num_threads(num_threads);
-  #pragma omp parallel sections
+  int32_t **B_nodes = NULL;
+  if (placement == PLACEMENT_NONE)
   {
-    #pragma omp section
+    generate_operands(fa.data ? NULL : A, fb.data ? NULL : B, n, seed);
+  }
+  else
+  {
+    // Con colocación NUMA, A y C las toca primero el hilo que las calcula
+    placement_bind_omp(&topo, num_threads);
+    first_touch(fa.data ? NULL : A, C, n, seed);
+    if (!fb.data)
     {
-      generate_matrix(A, n);
+      generate_matrix(B, n, seed, MATRIX_B, GEMM_B_NORMAL);
     }
-    #pragma omp section
+  }
+
+  // Transponer B una sola vez, en una etapa aparte: todas las versiones
+  // pasan al kernel B[j * n + k]
+  double t_transpose;
+  int32_t *Bt = transpose_stage(B, n, &t_transpose);
+  if (!Bt)
+  {
+    printf("Error al asignar memoria\n");
+    return 1;
+  }
+  matfile_release(&fb, B);
+  B = Bt;
+
+  if (placement == PLACEMENT_REPLICATE)
+  {
+    B_nodes = replicate_per_node(B, (size_t)n * n, &topo);
+    if (!B_nodes)
     {
-      generate_matrix(B, n);
+      printf("Error al asignar memoria\n");
+      return 1;
     }
   }
 
@@ -78,7 +202,8 @@ int main(int argc, char *argv[])
   struct timespec start, end;
   clock_gettime(CLOCK_MONOTONIC, &start);
 
-  multiply_matrices(A, B, C, n, num_threads);
+  multiply_matrices(A, B, B_nodes, C, n, num_threads,
+                    (placement != PLACEMENT_NONE) ? &topo : NULL);
 
   clock_gettime(CLOCK_MONOTONIC, &end);
 
@@ -115,11 +240,28 @@ int main(int argc, char *argv[])
 
   printf("Tiempo de multiplicacion con %d hilos (OpenMP Sections): %.6f segundos\n",
          num_threads, elapsed);
+  printf("Tiempo de transposicion de B: %.6f segundos\n", t_transpose);
+
+  if (placement != PLACEMENT_NONE)
+  {
+    printf("Colocacion %s con %d nodos NUMA\n", placement_name(placement),
+           topo.num_nodes);
+    free_replicas(B_nodes, &topo);
+    topology_free(&topo);
+  }
+
+  // Comprobar C = A * B con Freivalds (--verify)
+  int correcto = !verify || freivalds_verify(A, B, GEMM_INT32,
+                                             GEMM_B_TRANSPOSED, C, n, seed);
 
   // Liberar memoria
-  free(A);
+  matfile_release(&fa, A);
   free(B);
-  free(C);
+  if (!matfile_release(&fc, C))
+  {
+    printf("Error al escribir C\n");
+    return 1;
+  }
 
-  return 0;
+  return correcto ? 0 : 1;
 }
\ No newline at end of file
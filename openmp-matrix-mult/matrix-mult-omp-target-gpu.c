@@ -3,19 +3,27 @@
 #include <time.h>
 #include <stdint.h>
 #include <omp.h>
+#include "rng.h"
+#include "transpose.h"
+#include "matfile.h"
+#include "verify.h"
+#include "perfctr.h"
 
 // Generar una matriz cuadrada NxN con enteros aleatorios
-void generate_matrix(int32_t *matrix, int n)
+void generate_matrix(int32_t *matrix, int n, uint64_t seed, int id,
+                     GemmLayout layout)
 {
-  for (int i = 0; i < n * n; i++) {
-    matrix[i] = rand() % 100;
-  }
+  generate_matrix_philox(matrix, n, seed, id, layout);
 }
 
 // Multiplicar matrices usando target para offloading a dispositivos
 void multiply_matrices(int32_t *A, int32_t *B, int32_t *C, int n, int num_threads)
 {
   int size = n * n;
+  // Los contadores solo ven el hilo del host que lanza el kernel, copia
+  // los datos y espera
+  PerfPhase *perf = perfctr_phase_create("multiply_matrices");
+  perfctr_enter(perf, 0);
   
   #pragma omp target teams distribute parallel for collapse(2) \
     map(to: A[0:size], B[0:size]) map(from: C[0:size]) \
@@ -29,13 +37,24 @@ void multiply_matrices(int32_t *A, int32_t *B, int32_t *C, int n, int num_thread
       C[i * n + j] = sum;
     }
   }
+
+  perfctr_leave(perf, 0);
+  perfctr_phase_finish(perf, 0);
 }
 
 int main(int argc, char *argv[])
 {
+  int verify = verify_requested(&argc, argv);
+  uint64_t seed;
+  if (!seed_requested(&argc, argv, &seed))
+  {
+    printf("La semilla de --seed debe ser un entero sin signo\n");
+    return 1;
+  }
+
   if (argc != 3)
   {
-    printf("Uso: %s <tamano_matriz> <num_teams>\n", argv[0]);
+    printf("Uso: %s <tamano_matriz> <num_teams> [--verify] [--seed N]\n", argv[0]);
     return 1;
   }
 
@@ -48,12 +67,19 @@ int main(int argc, char *argv[])
     return 1;
   }
 
-  srand(time(NULL));
+  // Operandos y resultado en ficheros mapeados si se piden
+  MatFile fa, fb, fc;
+  if (!matfile_operand("GEMM_A_FILE", n, seed, MATRIX_A, &fa) ||
+      !matfile_operand("GEMM_B_FILE", n, seed, MATRIX_B, &fb) ||
+      !matfile_result(n, &fc))
+  {
+    return 1;
+  }
 
   // Reservar memoria dinámica
-  int32_t *A = (int32_t *)malloc(n * n * sizeof(int32_t));
-  int32_t *B = (int32_t *)malloc(n * n * sizeof(int32_t));
-  int32_t *C = (int32_t *)malloc(n * n * sizeof(int32_t));
+  int32_t *A = fa.data ? fa.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *B = fb.data ? fb.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *C = fc.data ? fc.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
 
   if (!A || !B || !C)
   {
@@ -62,8 +88,26 @@ int main(int argc, char *argv[])
   }
 
   // Llenar matrices con números aleatorios
-  generate_matrix(A, n);
-  generate_matrix(B, n);
+  if (!fa.data)
+  {
+    generate_matrix(A, n, seed, MATRIX_A, GEMM_B_NORMAL);
+  }
+  if (!fb.data)
+  {
+    generate_matrix(B, n, seed, MATRIX_B, GEMM_B_NORMAL);
+  }
+
+  // Transponer B una sola vez, en una etapa aparte: todas las versiones
+  // pasan al kernel B[j * n + k]
+  double t_transpose;
+  int32_t *Bt = transpose_stage(B, n, &t_transpose);
+  if (!Bt)
+  {
+    printf("Error al asignar memoria\n");
+    return 1;
+  }
+  matfile_release(&fb, B);
+  B = Bt;
 
   // Medir tiempo
   struct timespec start, end;
@@ -106,11 +150,20 @@ int main(int argc, char *argv[])
 
   printf("Tiempo de multiplicacion con %d teams (OpenMP Target): %.6f segundos\n",
          num_threads, elapsed);
+  printf("Tiempo de transposicion de B: %.6f segundos\n", t_transpose);
+
+  // Comprobar C = A * B con Freivalds (--verify)
+  int correcto = !verify || freivalds_verify(A, B, GEMM_INT32,
+                                             GEMM_B_TRANSPOSED, C, n, seed);
 
   // Liberar memoria
-  free(A);
+  matfile_release(&fa, A);
   free(B);
-  free(C);
+  if (!matfile_release(&fc, C))
+  {
+    printf("Error al escribir C\n");
+    return 1;
+  }
 
-  return 0;
+  return correcto ? 0 : 1;
 }
\ No newline at end of file
@@ -2,65 +2,208 @@
 #include <stdlib.h>
 #include <time.h>
 #include <stdint.h>
+#include <string.h>
 #include <omp.h>
+#include "gemm.h"
+#include "rng.h"
+#include "transpose.h"
+#include "matfile.h"
+#include "verify.h"
+#include "tune.h"
+#include "perfctr.h"
+
+#define CORTE_STRASSEN 256
 
 // Generar una matriz cuadrada NxN con enteros aleatorios
-void generate_matrix(int32_t *matrix, int n)
+void generate_matrix(int32_t *matrix, int n, uint64_t seed, int id,
+                     GemmLayout layout)
+{
+  generate_matrix_philox(matrix, n, seed, id, layout);
+}
+
+// Bloques de C por hilo por debajo de los cuales se parten los bloques de
+// tareas para que haya trabajo para todos
+#define BLOQUES_POR_HILO 4
+#define LADO_MINIMO 32
+
+// Valor positivo de la variable de entorno name, o 0
+int env_positive(const char *name)
+{
+  const char *value = getenv(name);
+  return (value != NULL && atoi(value) > 0) ? atoi(value) : 0;
+}
+
+// Tamaño de los bloques de C de cada tarea: los del kernel (mc x nc), o
+// más pequeños si con ellos no hay BLOQUES_POR_HILO bloques por hilo (n
+// pequeña o muchos hilos)
+void task_tiles(int n, int num_threads, const TileConfig *tiles, int *ti,
+                int *tj)
+{
+  *ti = (tiles->mc < n) ? tiles->mc : n;
+  *tj = (tiles->nc < n) ? tiles->nc : n;
+  while (gemm_num_blocks(n, *ti) * gemm_num_blocks(n, *tj) <
+         BLOQUES_POR_HILO * num_threads)
+  {
+    if (*tj / 2 >= LADO_MINIMO && *tj >= *ti)
+      *tj /= 2;
+    else if (*ti / 2 >= LADO_MINIMO)
+      *ti /= 2;
+    else
+      break;
+  }
+}
+
+// Cadena de tareas del bloque de C número b: una por trozo de k, con
+// depend(inout) sobre el bloque (la primera escribe con beta 0 y el resto
+// acumula). Con un solo trozo la tarea no se difiere
+void create_k_chain(const int32_t *A, const int32_t *B, int32_t *C, int n,
+                    int b, int ti, int tj, const TileConfig *tiles)
+{
+  int bloques_j = gemm_num_blocks(n, tj);
+  int bloques_k = gemm_num_blocks(n, tiles->kc);
+  int i0 = (b / bloques_j) * ti;
+  int j0 = (b % bloques_j) * tj;
+  int mb = (i0 + ti < n) ? ti : n - i0;
+  int nb = (j0 + tj < n) ? tj : n - j0;
+  int32_t *Cij = C + (size_t)i0 * n + j0;
+
+  for (int k0 = 0; k0 < n; k0 += tiles->kc) {
+    int kb = (k0 + tiles->kc < n) ? tiles->kc : n - k0;
+    #pragma omp task depend(inout: Cij[0]) if(bloques_k > 1)
+    hpc_gemm_i32_tiles(GEMM_NO_TRANS, GEMM_TRANS, mb, nb, kb, 1,
+                       A + (size_t)i0 * n + k0, n, B + (size_t)j0 * n + k0, n,
+                       (k0 == 0) ? 0 : 1, Cij, n, tiles);
+  }
+}
+
+// Una tarea por bloque (i, j, k): las de un mismo bloque de C forman una
+// cadena y las de bloques distintos son independientes. Las cadenas se
+// crean con un taskloop sobre los bloques de C, así que la creación también
+// se reparte entre los hilos, con el grano de GEMM_TASK_GRAIN (bloques de C
+// por tarea del taskloop) o GEMM_TASK_NUM (número de tareas del taskloop);
+// sin ninguna lo decide el runtime. Se llama desde una tarea o un bloque
+// single, y al volver C está completa (el taskloop espera a todas sus
+// descendientes)
+void multiply_tile_dag(const int32_t *A, const int32_t *B, int32_t *C, int n,
+                       int ti, int tj, const TileConfig *tiles)
 {
-  for (int i = 0; i < n * n; i++) {
-    matrix[i] = rand() % 100;
+  int bloques_c = gemm_num_blocks(n, ti) * gemm_num_blocks(n, tj);
+  int grano = env_positive("GEMM_TASK_GRAIN");
+  int num_tareas = env_positive("GEMM_TASK_NUM");
+
+  if (num_tareas > 0) {
+    #pragma omp taskloop num_tasks(num_tareas)
+    for (int b = 0; b < bloques_c; b++)
+      create_k_chain(A, B, C, n, b, ti, tj, tiles);
+  } else if (grano > 0) {
+    #pragma omp taskloop grainsize(grano)
+    for (int b = 0; b < bloques_c; b++)
+      create_k_chain(A, B, C, n, b, ti, tj, tiles);
+  } else {
+    #pragma omp taskloop
+    for (int b = 0; b < bloques_c; b++)
+      create_k_chain(A, B, C, n, b, ti, tj, tiles);
   }
 }
 
-// Multiplicar matrices usando tasks de OpenMP
+// Multiplicar matrices usando tasks de OpenMP. Si se llama desde dentro de
+// una región paralela las tareas van al equipo que ya existe en lugar de
+// abrir otro (sin sobresuscribir los procesadores)
 void multiply_matrices(int32_t *A, int32_t *B, int32_t *C, int n, int num_threads)
 {
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+  int ti, tj;
+
+  if (omp_in_parallel())
+  {
+    task_tiles(n, omp_get_num_threads(), &tiles, &ti, &tj);
+    multiply_tile_dag(A, B, C, n, ti, tj, &tiles);
+    return;
+  }
+
+  task_tiles(n, num_threads, &tiles, &ti, &tj);
+  PerfPhase *perf = perfctr_phase_create("multiply_matrices");
+
   omp_set_num_threads(num_threads);
   
   #pragma omp parallel
   {
+    // Las tareas se ejecutan en cualquier hilo del equipo: cada uno cuenta
+    // desde que entra en la región hasta que se vacía la cola de tareas
+    perfctr_enter(perf, omp_get_thread_num());
+
     #pragma omp single
-    {
-      for (int i = 0; i < n; i++) {
-        #pragma omp task firstprivate(i)
-        {
-          for (int j = 0; j < n; j++) {
-            int32_t sum = 0;
-            for (int k = 0; k < n; k++) {
-              sum += A[i * n + k] * B[j * n + k];
-            }
-            C[i * n + j] = sum;
-          }
-        }
-      }
-      #pragma omp taskwait
-    }
+    multiply_tile_dag(A, B, C, n, ti, tj, &tiles);
+
+    perfctr_leave(perf, omp_get_thread_num());
+  }
+
+  perfctr_phase_finish(perf, 0);
+}
+
+// Multiplicar matrices con Strassen-Winograd: los 7 productos de cada nivel
+// son tasks con dependencias; por debajo de 'corte' se usa el kernel comun
+void multiply_strassen(int32_t *A, int32_t *B, int32_t *C, int n, int num_threads,
+                       int corte)
+{
+  TileConfig tiles;
+  gemm_tiles_init(&tiles);
+
+  omp_set_num_threads(num_threads);
+
+  #pragma omp parallel
+  {
+    #pragma omp single
+    gemm_strassen(A, B, C, n, GEMM_B_TRANSPOSED, corte, &tiles);
   }
 }
 
 int main(int argc, char *argv[])
 {
-  if (argc != 3)
+  int verify = verify_requested(&argc, argv);
+  uint64_t seed;
+  if (!seed_requested(&argc, argv, &seed))
+  {
+    printf("La semilla de --seed debe ser un entero sin signo\n");
+    return 1;
+  }
+
+  if (argc < 3 || argc > 5)
   {
-    printf("Uso: %s <tamano_matriz> <num_hilos>\n", argv[0]);
+    printf("Uso: %s <tamano_matriz> <num_hilos|0> [bloques|strassen] [corte] [--verify] [--seed N]\n", argv[0]);
     return 1;
   }
 
   int n = atoi(argv[1]);
   int num_threads = atoi(argv[2]);
+  int strassen = (argc > 3 && strcmp(argv[3], "strassen") == 0);
+  int corte = (argc > 4) ? atoi(argv[4]) : CORTE_STRASSEN;
 
-  if (n <= 0 || num_threads <= 0)
+  if (n <= 0 || num_threads < 0 || corte <= 0)
   {
-    printf("El tamaño y número de hilos deben ser positivos\n");
+    printf("El tamaño y el corte deben ser positivos y el número de hilos no negativo\n");
     return 1;
   }
 
-  srand(time(NULL));
+  // Bloques, orden y planificación del perfil de ajuste de la máquina; con
+  // 0 hilos se usan también los del perfil (o todos los procesadores)
+  tune_select(n, 1);
+  num_threads = tune_threads(num_threads, omp_get_num_procs());
+
+  // Operandos y resultado en ficheros mapeados si se piden
+  MatFile fa, fb, fc;
+  if (!matfile_operand("GEMM_A_FILE", n, seed, MATRIX_A, &fa) ||
+      !matfile_operand("GEMM_B_FILE", n, seed, MATRIX_B, &fb) ||
+      !matfile_result(n, &fc))
+  {
+    return 1;
+  }
 
   // Reservar memoria dinámica
-  int32_t *A = (int32_t *)malloc(n * n * sizeof(int32_t));
-  int32_t *B = (int32_t *)malloc(n * n * sizeof(int32_t));
-  int32_t *C = (int32_t *)malloc(n * n * sizeof(int32_t));
+  int32_t *A = fa.data ? fa.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *B = fb.data ? fb.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
+  int32_t *C = fc.data ? fc.data : (int32_t *)malloc((size_t)n * n * sizeof(int32_t));
 
   if (!A || !B || !C)
   {
@@ -68,15 +211,37 @@ int main(int argc, char *argv[])
     return 1;
   }
 
-  // Llenar matrices con números aleatorios
-  generate_matrix(A, n);
-  generate_matrix(B, n);
+  // Llenar matrices con números aleatorios (en paralelo)
+  omp_set_num_threads(num_threads);
+  if (!fa.data)
+  {
+    generate_matrix(A, n, seed, MATRIX_A, GEMM_B_NORMAL);
+  }
+  if (!fb.data)
+  {
+    generate_matrix(B, n, seed, MATRIX_B, GEMM_B_NORMAL);
+  }
+
+  // Transponer B una sola vez, en una etapa aparte: todas las versiones
+  // pasan al kernel B[j * n + k]
+  double t_transpose;
+  int32_t *Bt = transpose_stage(B, n, &t_transpose);
+  if (!Bt)
+  {
+    printf("Error al asignar memoria\n");
+    return 1;
+  }
+  matfile_release(&fb, B);
+  B = Bt;
 
   // Medir tiempo
   struct timespec start, end;
   clock_gettime(CLOCK_MONOTONIC, &start);
 
-  multiply_matrices(A, B, C, n, num_threads);
+  if (strassen)
+    multiply_strassen(A, B, C, n, num_threads, corte);
+  else
+    multiply_matrices(A, B, C, n, num_threads);
 
   clock_gettime(CLOCK_MONOTONIC, &end);
 
@@ -111,13 +276,35 @@ int main(int argc, char *argv[])
     }
   }
 
-  printf("Tiempo de multiplicacion con %d hilos (OpenMP Tasks): %.6f segundos\n",
-         num_threads, elapsed);
+  if (strassen)
+    printf("Tiempo de multiplicacion con %d hilos (OpenMP Tasks Strassen, corte %d): %.6f segundos\n",
+           num_threads, corte, elapsed);
+  else
+  {
+    TileConfig tiles;
+    int ti, tj;
+    gemm_tiles_init(&tiles);
+    task_tiles(n, num_threads, &tiles, &ti, &tj);
+    printf("Tiempo de multiplicacion con %d hilos (OpenMP Tasks): %.6f segundos\n",
+           num_threads, elapsed);
+    printf("Tareas: bloques de C de %dx%d y k en trozos de %d (%d tareas)\n",
+           ti, tj, tiles.kc, gemm_num_blocks(n, ti) * gemm_num_blocks(n, tj) *
+           gemm_num_blocks(n, tiles.kc));
+  }
+  printf("Tiempo de transposicion de B: %.6f segundos\n", t_transpose);
+
+  // Comprobar C = A * B con Freivalds (--verify)
+  int correcto = !verify || freivalds_verify(A, B, GEMM_INT32,
+                                             GEMM_B_TRANSPOSED, C, n, seed);
 
   // Liberar memoria
-  free(A);
+  matfile_release(&fa, A);
   free(B);
-  free(C);
+  if (!matfile_release(&fc, C))
+  {
+    printf("Error al escribir C\n");
+    return 1;
+  }
 
-  return 0;
+  return correcto ? 0 : 1;
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <unistd.h>
 #include <sys/wait.h>
 #include <sys/shm.h>
+#include "perfctr.h"
 
 int main(int argc, char *argv[]) {
   if (argc != 3) {
@@ -38,11 +39,15 @@ int main(int argc, char *argv[]) {
       unsigned long long end = (p == num_procs - 1) ? num_trials : start + base;
       unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)getpid();
       unsigned long long local_in = 0;
+      PerfPhase *perf = perfctr_phase_create("ensayos");
+      perfctr_enter(perf, 0);
       for (unsigned long long i = start; i < end; i++) {
         double x = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * 2.0 - 1.0;
         double y = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * 2.0 - 1.0;
         if (x * x + y * y <= 1.0) local_in++;
       }
+      perfctr_leave(perf, 0);
+      perfctr_phase_finish(perf, p);
       shm_counts[p] = local_in;
       shmdt(shm_counts);
       _exit(0);
@@ -10,6 +10,7 @@
 #include <unistd.h>
 #include <sys/wait.h>
 #include <sys/shm.h>
+#include "perfctr.h"
 
 int main(int argc, char *argv[]) {
   if (argc < 3) {
@@ -53,11 +54,15 @@ int main(int argc, char *argv[]) {
       unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)getpid();
       unsigned long long local_crosses = 0;
 
+      PerfPhase *perf = perfctr_phase_create("ensayos");
+      perfctr_enter(perf, 0);
       for (unsigned long long i = start; i < end; i++) {
         double x = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * (D / 2.0);
         double theta = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * (PI / 2.0);
         if (x <= (L / 2.0) * sin(theta)) local_crosses++;
       }
+      perfctr_leave(perf, 0);
+      perfctr_phase_finish(perf, p);
 
       shm_counts[p] = local_crosses;
       shmdt(shm_counts);
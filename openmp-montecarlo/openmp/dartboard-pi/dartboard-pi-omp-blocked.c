@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <time.h>
 #include <omp.h>
+#include "perfctr.h"
 
 // Versión OpenMP con procesamiento por bloques - mejor localidad de cache
 
@@ -24,13 +25,15 @@ int main(int argc, char *argv[]) {
   const unsigned long long BLOCK_SIZE = 10000;
   unsigned long long num_blocks = (num_trials + BLOCK_SIZE - 1) / BLOCK_SIZE;
   
+  PerfPhase *perf = perfctr_phase_create("ensayos");
   double t0 = omp_get_wtime();
 
   #pragma omp parallel reduction(+:total_in)
   {
     unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)omp_get_thread_num() ^ (unsigned int)getpid();
+    perfctr_enter(perf, omp_get_thread_num());
     
-    #pragma omp for schedule(static)
+    #pragma omp for schedule(static) nowait
     for (unsigned long long block = 0; block < num_blocks; block++) {
       unsigned long long start = block * BLOCK_SIZE;
       unsigned long long end = (start + BLOCK_SIZE < num_trials) ? start + BLOCK_SIZE : num_trials;
@@ -41,6 +44,8 @@ int main(int argc, char *argv[]) {
         if (x * x + y * y <= 1.0) total_in++;
       }
     }
+
+    perfctr_leave(perf, omp_get_thread_num());
   }
 
   double elapsed = omp_get_wtime() - t0;
@@ -49,5 +54,6 @@ int main(int argc, char *argv[]) {
   printf("Dartboard OpenMP blocked: trials=%llu in_circle=%llu pi_est=%.10f tiempo=%.6f s\n",
          num_trials, total_in, pi_est, elapsed);
 
+  perfctr_phase_finish(perf, 0);
   return 0;
 }
\ No newline at end of file
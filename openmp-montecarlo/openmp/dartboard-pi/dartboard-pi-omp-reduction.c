@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <time.h>
 #include <omp.h>
+#include "perfctr.h"
 
 // Versión OpenMP con reduction - evita atomic operations
 
@@ -20,18 +21,22 @@ int main(int argc, char *argv[]) {
   }
   unsigned long long total_in = 0;
   
+  PerfPhase *perf = perfctr_phase_create("ensayos");
   double t0 = omp_get_wtime();
 
   #pragma omp parallel reduction(+:total_in)
   {
     unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)omp_get_thread_num() ^ (unsigned int)getpid();
+    perfctr_enter(perf, omp_get_thread_num());
     
-    #pragma omp for
+    #pragma omp for nowait
     for (unsigned long long i = 0; i < num_trials; i++) {
       double x = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * 2.0 - 1.0;
       double y = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * 2.0 - 1.0;
       if (x * x + y * y <= 1.0) total_in++;
     }
+
+    perfctr_leave(perf, omp_get_thread_num());
   }
 
   double elapsed = omp_get_wtime() - t0;
@@ -40,5 +45,6 @@ int main(int argc, char *argv[]) {
   printf("Dartboard OpenMP reduction: trials=%llu in_circle=%llu pi_est=%.10f tiempo=%.6f s\n",
          num_trials, total_in, pi_est, elapsed);
 
+  perfctr_phase_finish(perf, 0);
   return 0;
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <time.h>
 #include <omp.h>
+#include "perfctr.h"
 
 // Versión OpenMP con tasks - paralelismo basado en tareas
 
@@ -24,10 +25,15 @@ int main(int argc, char *argv[]) {
   const int NUM_TASKS = omp_get_num_threads() * 4;
   unsigned long long chunk_size = num_trials / NUM_TASKS;
   
+  PerfPhase *perf = perfctr_phase_create("ensayos");
   double t0 = omp_get_wtime();
 
   #pragma omp parallel
   {
+    // Las tareas se ejecutan en cualquier hilo del equipo: cada uno cuenta
+    // hasta que se vacía la cola de tareas
+    perfctr_enter(perf, omp_get_thread_num());
+
     #pragma omp single
     {
       for (int t = 0; t < NUM_TASKS; t++) {
@@ -50,6 +56,8 @@ int main(int argc, char *argv[]) {
         }
       }
     }
+
+    perfctr_leave(perf, omp_get_thread_num());
   }
 
   double elapsed = omp_get_wtime() - t0;
@@ -58,5 +66,6 @@ int main(int argc, char *argv[]) {
   printf("Dartboard OpenMP tasks: trials=%llu in_circle=%llu pi_est=%.10f tiempo=%.6f s\n",
          num_trials, total_in, pi_est, elapsed);
 
+  perfctr_phase_finish(perf, 0);
   return 0;
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <math.h>
 #include <omp.h>
 #include <unistd.h>
+#include "perfctr.h"
 
 // Versión OpenMP - paralelización del bucle principal
 
@@ -26,20 +27,24 @@ int main(int argc, char *argv[]) {
   const double PI = acos(-1.0);
   unsigned long long total_crosses = 0;
 
+  PerfPhase *perf = perfctr_phase_create("ensayos");
   double t0 = omp_get_wtime();
 
   #pragma omp parallel
   {
     unsigned long long local_crosses = 0;
     unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)omp_get_thread_num() ^ (unsigned int)getpid();
+    perfctr_enter(perf, omp_get_thread_num());
 
-    #pragma omp for
+    #pragma omp for nowait
     for (unsigned long long i = 0; i < num_trials; i++) {
       double x = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * (D / 2.0);
       double theta = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * (PI / 2.0);
       if (x <= (L / 2.0) * sin(theta)) local_crosses++;
     }
 
+    perfctr_leave(perf, omp_get_thread_num());
+
     #pragma omp atomic
     total_crosses += local_crosses;
   }
@@ -50,5 +55,6 @@ int main(int argc, char *argv[]) {
   printf("Buffon OpenMP: trials=%llu crosses=%llu P=%.10f tiempo=%.6f s\n",
          num_trials, total_crosses, p, elapsed);
 
+  perfctr_phase_finish(perf, 0);
   return 0;
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <math.h>
 #include <omp.h>
 #include <unistd.h>
+#include "perfctr.h"
 
 // Versión OpenMP con procesamiento por bloques - mejor localidad de cache
 
@@ -30,13 +31,15 @@ int main(int argc, char *argv[]) {
   const unsigned long long BLOCK_SIZE = 10000;
   unsigned long long num_blocks = (num_trials + BLOCK_SIZE - 1) / BLOCK_SIZE;
 
+  PerfPhase *perf = perfctr_phase_create("ensayos");
   double t0 = omp_get_wtime();
 
   #pragma omp parallel reduction(+:total_crosses)
   {
     unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)omp_get_thread_num() ^ (unsigned int)getpid();
+    perfctr_enter(perf, omp_get_thread_num());
 
-    #pragma omp for schedule(static)
+    #pragma omp for schedule(static) nowait
     for (unsigned long long block = 0; block < num_blocks; block++) {
       unsigned long long start = block * BLOCK_SIZE;
       unsigned long long end = (start + BLOCK_SIZE < num_trials) ? start + BLOCK_SIZE : num_trials;
@@ -47,6 +50,8 @@ int main(int argc, char *argv[]) {
         if (x <= (L / 2.0) * sin(theta)) total_crosses++;
       }
     }
+
+    perfctr_leave(perf, omp_get_thread_num());
   }
 
   double elapsed = omp_get_wtime() - t0;
@@ -55,5 +60,6 @@ int main(int argc, char *argv[]) {
   printf("Buffon OpenMP blocked: trials=%llu crosses=%llu P=%.10f tiempo=%.6f s\n",
          num_trials, total_crosses, p, elapsed);
 
+  perfctr_phase_finish(perf, 0);
   return 0;
 }
\ No newline at end of file
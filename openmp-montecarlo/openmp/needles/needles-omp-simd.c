@@ -5,6 +5,7 @@
 #include <math.h>
 #include <omp.h>
 #include <unistd.h>
+#include "perfctr.h"
 
 // Versión OpenMP con SIMD - vectorización para mejor rendimiento
 
@@ -26,19 +27,23 @@ int main(int argc, char *argv[]) {
   const double PI = acos(-1.0);
   unsigned long long total_crosses = 0;
 
+  PerfPhase *perf = perfctr_phase_create("ensayos");
   double t0 = omp_get_wtime();
 
   #pragma omp parallel reduction(+:total_crosses)
   {
     unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)omp_get_thread_num() ^ (unsigned int)getpid();
+    perfctr_enter(perf, omp_get_thread_num());
 
     // for simd para vectorización automática
-    #pragma omp for simd
+    #pragma omp for simd nowait
     for (unsigned long long i = 0; i < num_trials; i++) {
       double x = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * (D / 2.0);
       double theta = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * (PI / 2.0);
       if (x <= (L / 2.0) * sin(theta)) total_crosses++;
     }
+
+    perfctr_leave(perf, omp_get_thread_num());
   }
 
   double elapsed = omp_get_wtime() - t0;
@@ -47,5 +52,6 @@ int main(int argc, char *argv[]) {
   printf("Buffon OpenMP SIMD: trials=%llu crosses=%llu P=%.10f tiempo=%.6f s\n",
          num_trials, total_crosses, p, elapsed);
 
+  perfctr_phase_finish(perf, 0);
   return 0;
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <math.h>
 #include <omp.h>
 #include <unistd.h>
+#include "perfctr.h"
 
 // Versión OpenMP con tasks - paralelismo basado en tareas
 
@@ -30,10 +31,15 @@ int main(int argc, char *argv[]) {
   const int NUM_TASKS = omp_get_num_threads() * 4;
   unsigned long long chunk_size = num_trials / NUM_TASKS;
 
+  PerfPhase *perf = perfctr_phase_create("ensayos");
   double t0 = omp_get_wtime();
 
   #pragma omp parallel
   {
+    // Las tareas se ejecutan en cualquier hilo del equipo: cada uno cuenta
+    // hasta que se vacía la cola de tareas
+    perfctr_enter(perf, omp_get_thread_num());
+
     #pragma omp single
     {
       for (int t = 0; t < NUM_TASKS; t++) {
@@ -56,6 +62,8 @@ int main(int argc, char *argv[]) {
         }
       }
     }
+
+    perfctr_leave(perf, omp_get_thread_num());
   }
 
   double elapsed = omp_get_wtime() - t0;
@@ -64,5 +72,6 @@ int main(int argc, char *argv[]) {
   printf("Buffon OpenMP tasks: trials=%llu crosses=%llu P=%.10f tiempo=%.6f s\n",
          num_trials, total_crosses, p, elapsed);
 
+  perfctr_phase_finish(perf, 0);
   return 0;
 }
\ No newline at end of file
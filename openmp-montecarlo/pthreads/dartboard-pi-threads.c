@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <time.h>
 #include <pthread.h>
+#include "perfctr.h"
 
 typedef struct {
   int id;
@@ -11,6 +12,7 @@ typedef struct {
   unsigned long long num_trials;
   unsigned long long local_in;
   unsigned int seed;
+  PerfPhase *perf;
 } TData;
 
 void* thread_func(void* arg) {
@@ -21,11 +23,13 @@ void* thread_func(void* arg) {
   unsigned long long in_circle = 0;
   unsigned int seed = td->seed;
 
+  perfctr_enter(td->perf, td->id);
   for (unsigned long long i = start; i < end; i++) {
     double x = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * 2.0 - 1.0;
     double y = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * 2.0 - 1.0;
     if (x * x + y * y <= 1.0) in_circle++;
   }
+  perfctr_leave(td->perf, td->id);
 
   td->local_in = in_circle;
   return NULL;
@@ -46,6 +50,7 @@ int main(int argc, char *argv[]) {
   TData td[num_threads];
   unsigned int base_seed = (unsigned int)time(NULL);
 
+  PerfPhase *perf = perfctr_phase_create("ensayos");
   struct timespec t0, t1;
   clock_gettime(CLOCK_MONOTONIC, &t0);
 
@@ -55,6 +60,7 @@ int main(int argc, char *argv[]) {
     td[i].num_trials = num_trials;
     td[i].local_in = 0;
     td[i].seed = base_seed ^ (unsigned int)(i * 0x9e3779b9);
+    td[i].perf = perf;
     pthread_create(&threads[i], NULL, thread_func, &td[i]);
   }
 
@@ -71,5 +77,6 @@ int main(int argc, char *argv[]) {
   printf("Dartboard hilos: trials=%llu threads=%d in_circle=%llu pi_est=%.10f tiempo=%.6f s\n",
          num_trials, num_threads, total_in, pi_est, elapsed);
 
+  perfctr_phase_finish(perf, 0);
   return 0;
 }
@@ -10,6 +10,7 @@
 #include <math.h>
 #include <pthread.h>
 #include <unistd.h>
+#include "perfctr.h"
 
 typedef struct {
   int id;
@@ -18,6 +19,7 @@ typedef struct {
   double L, D;
   unsigned long long local_crosses;
   unsigned int seed;
+  PerfPhase *perf;
 } ThreadData;
 
 static double PI;
@@ -33,11 +35,13 @@ void* thread_func(void* arg) {
   unsigned long long crosses = 0;
   unsigned int seed = td->seed;
 
+  perfctr_enter(td->perf, td->id);
   for (unsigned long long i = start; i < end; i++) {
     double x = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * (td->D / 2.0);
     double theta = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * (PI / 2.0);
     if (x <= (td->L / 2.0) * sin(theta)) crosses++;
   }
+  perfctr_leave(td->perf, td->id);
 
   td->local_crosses = crosses;
   return NULL;
@@ -70,6 +74,7 @@ int main(int argc, char *argv[]) {
 
   unsigned int base_seed = (unsigned int)time(NULL);
 
+  PerfPhase *perf = perfctr_phase_create("ensayos");
   struct timespec t0, t1;
   clock_gettime(CLOCK_MONOTONIC, &t0);
 
@@ -81,6 +86,7 @@ int main(int argc, char *argv[]) {
     td[i].D = D;
     td[i].local_crosses = 0;
     td[i].seed = base_seed ^ (unsigned int)(i * 0x9e3779b9);
+    td[i].perf = perf;
     if (pthread_create(&threads[i], NULL, thread_func, &td[i]) != 0) {
       perror("pthread_create");
       return 1;
@@ -102,5 +108,6 @@ int main(int argc, char *argv[]) {
 
   free(threads);
   free(td);
+  perfctr_phase_finish(perf, 0);
   return 0;
 }
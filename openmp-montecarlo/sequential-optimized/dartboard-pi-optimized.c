@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <time.h>
 #include <math.h>
+#include "perfctr.h"
 
 // Optimizaciones:
 // 1. Loop unrolling para mejor uso de pipeline
@@ -24,8 +25,10 @@ int main(int argc, char *argv[]) {
   // Precalcular constantes
   const double scale = 2.0 / ((double)RAND_MAX + 1.0);
   
+  PerfPhase *perf = perfctr_phase_create("ensayos");
   struct timespec t0, t1;
   clock_gettime(CLOCK_MONOTONIC, &t0);
+  perfctr_enter(perf, 0);
 
   // Loop unrolling (4x) para mejor rendimiento
   unsigned long long i;
@@ -60,6 +63,7 @@ int main(int argc, char *argv[]) {
     if (x * x + y * y <= 1.0) in_circle++;
   }
 
+  perfctr_leave(perf, 0);
   clock_gettime(CLOCK_MONOTONIC, &t1);
   double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
 
@@ -67,5 +71,6 @@ int main(int argc, char *argv[]) {
   printf("Dartboard secuencial optimizado: trials=%llu in_circle=%llu pi_est=%.10f tiempo=%.6f s\n",
          num_trials, in_circle, pi_est, elapsed);
 
+  perfctr_phase_finish(perf, 0);
   return 0;
 }
\ No newline at end of file
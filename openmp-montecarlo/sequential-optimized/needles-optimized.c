@@ -4,6 +4,7 @@
 #include <time.h>
 #include <math.h>
 #include <unistd.h>
+#include "perfctr.h"
 
 // Optimizaciones:
 // 1. Precalcular constantes
@@ -34,8 +35,10 @@ int main(int argc, char *argv[]) {
   const double scale_theta = (PI / 2.0) / ((double)RAND_MAX + 1.0);
   const double half_L = L / 2.0;
 
+  PerfPhase *perf = perfctr_phase_create("ensayos");
   struct timespec t0, t1;
   clock_gettime(CLOCK_MONOTONIC, &t0);
+  perfctr_enter(perf, 0);
 
   // Loop unrolling (4x)
   unsigned long long i;
@@ -70,6 +73,7 @@ int main(int argc, char *argv[]) {
     if (x <= half_L * sin(theta)) crosses++;
   }
 
+  perfctr_leave(perf, 0);
   clock_gettime(CLOCK_MONOTONIC, &t1);
   double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
 
@@ -77,5 +81,6 @@ int main(int argc, char *argv[]) {
   printf("Buffon secuencial optimizado: trials=%llu crosses=%llu P=%.10f tiempo=%.6f s\n",
          num_trials, crosses, p, elapsed);
 
+  perfctr_phase_finish(perf, 0);
   return 0;
 }
\ No newline at end of file
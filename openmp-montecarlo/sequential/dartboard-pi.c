@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <time.h>
 #include <math.h>
+#include "perfctr.h"
 
 // Estimacion de pi lanzando dardos en el cuadrado [-1,1]x[-1,1]
 // Uso: ./dartboard_seq <num_trials>
@@ -19,8 +20,10 @@ int main(int argc, char *argv[]) {
   unsigned long long in_circle = 0;
   unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)getpid();
 
+  PerfPhase *perf = perfctr_phase_create("ensayos");
   struct timespec t0, t1;
   clock_gettime(CLOCK_MONOTONIC, &t0);
+  perfctr_enter(perf, 0);
 
   for (unsigned long long i = 0; i < num_trials; i++) {
     double x = ((double)rand_r(&seed) / ((double)RAND_MAX + 1.0)) * 2.0 - 1.0;
@@ -28,6 +31,7 @@ int main(int argc, char *argv[]) {
     if (x * x + y * y <= 1.0) in_circle++;
   }
 
+  perfctr_leave(perf, 0);
   clock_gettime(CLOCK_MONOTONIC, &t1);
   double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
 
@@ -35,5 +39,6 @@ int main(int argc, char *argv[]) {
   printf("Dartboard secuencial: trials=%llu in_circle=%llu pi_est=%.10f tiempo=%.6f s\n",
          num_trials, in_circle, pi_est, elapsed);
 
+  perfctr_phase_finish(perf, 0);
   return 0;
 }
@@ -4,6 +4,7 @@
 #include <time.h>
 #include <math.h>
 #include <unistd.h>
+#include "perfctr.h"
 
 int main(int argc, char *argv[]) {
   if (argc < 2) {
@@ -24,8 +25,10 @@ int main(int argc, char *argv[]) {
   unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)getpid();
   const double PI = acos(-1.0);
 
+  PerfPhase *perf = perfctr_phase_create("ensayos");
   struct timespec t0, t1;
   clock_gettime(CLOCK_MONOTONIC, &t0);
+  perfctr_enter(perf, 0);
 
   for (unsigned long long i = 0; i < num_trials; i++) {
     // aprovechamos la simetría: x en [0, D/2), theta en [0, PI/2)
@@ -37,6 +40,7 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  perfctr_leave(perf, 0);
   clock_gettime(CLOCK_MONOTONIC, &t1);
   double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
 
@@ -44,5 +48,6 @@ int main(int argc, char *argv[]) {
   printf("Buffon secuencial: trials=%llu crosses=%llu P=%.10f tiempo=%.6f s\n",
          num_trials, crosses, p, elapsed);
 
+  perfctr_phase_finish(perf, 0);
   return 0;
 }
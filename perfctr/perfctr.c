@@ -0,0 +1,355 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "perfctr.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define PERFCTR_DEFAULT_CSV "contadores.csv"
+
+// Contadores abiertos por un hilo. tid es el hilo del sistema que los abrió
+// (solo cuentan lo que ejecuta él); 0 si aún no se abrieron y -1 si no se
+// pudo abrir ninguno
+typedef struct {
+  int fd[PERFCTR_EVENTS];
+  long tid;
+} PerfSlot;
+
+struct PerfPhase {
+  const char *name;
+  PerfSlot slot[PERFCTR_MAX_THREADS];
+};
+
+// Valor de un contador al terminar: valid = 0 si no se abrió o no llegó a
+// estar en la PMU
+typedef struct {
+  uint64_t value[PERFCTR_EVENTS];
+  int valid[PERFCTR_EVENTS];
+} PerfValues;
+
+enum {
+  EV_CYCLES,
+  EV_INSTRUCTIONS,
+  EV_L1D_MISSES,
+  EV_LLC_MISSES,
+  EV_DTLB_MISSES,
+  EV_BRANCH_MISSES
+};
+
+static atomic_int warned;
+
+static int perfctr_enabled(void) {
+  const char *value = getenv("PERFCTR");
+  return value != NULL && atoi(value) > 0;
+}
+
+#ifdef __linux__
+
+// Tipo y configuración de cada evento, en el orden de EV_*
+static void event_attr(int e, struct perf_event_attr *attr) {
+  const uint64_t read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+  memset(attr, 0, sizeof(*attr));
+  attr->size = sizeof(*attr);
+  attr->type = PERF_TYPE_HARDWARE;
+  switch (e) {
+    case EV_CYCLES:
+      attr->config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case EV_INSTRUCTIONS:
+      attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case EV_L1D_MISSES:
+      attr->type = PERF_TYPE_HW_CACHE;
+      attr->config = PERF_COUNT_HW_CACHE_L1D | read_miss;
+      break;
+    case EV_LLC_MISSES:
+      attr->type = PERF_TYPE_HW_CACHE;
+      attr->config = PERF_COUNT_HW_CACHE_LL | read_miss;
+      break;
+    case EV_DTLB_MISSES:
+      attr->type = PERF_TYPE_HW_CACHE;
+      attr->config = PERF_COUNT_HW_CACHE_DTLB | read_miss;
+      break;
+    default:
+      attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+  }
+  // Cada evento va por separado y no en grupo: si la PMU no tiene hueco
+  // para todos a la vez el núcleo los multiplexa y se escalan al leer, en
+  // lugar de quedarse el grupo entero sin contar
+  attr->disabled = 1;
+  attr->exclude_kernel = 1;
+  attr->exclude_hv = 1;
+  attr->read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                      PERF_FORMAT_TOTAL_TIME_RUNNING;
+}
+
+static void warn_unavailable(int err) {
+  if (atomic_exchange(&warned, 1) == 0) {
+    fprintf(stderr, "PERFCTR: contadores hardware no disponibles (%s); "
+            "se continua sin ellos\n", strerror(err));
+  }
+}
+
+// Abrir los contadores del hilo que llama. Los que fallan se quedan en -1
+static void slot_open(PerfSlot *s, long self) {
+  int opened = 0;
+  int err = 0;
+
+  for (int e = 0; e < PERFCTR_EVENTS; e++) {
+    struct perf_event_attr attr;
+    event_attr(e, &attr);
+    s->fd[e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+                            PERF_FLAG_FD_CLOEXEC);
+    if (s->fd[e] >= 0) {
+      opened++;
+    } else if (err == 0) {
+      err = errno;
+    }
+  }
+
+  if (err != 0) {
+    warn_unavailable(err);
+  }
+  s->tid = opened ? self : -1;
+}
+
+static void slot_ioctl(PerfSlot *s, unsigned long request) {
+  for (int e = 0; e < PERFCTR_EVENTS; e++) {
+    if (s->fd[e] >= 0) {
+      ioctl(s->fd[e], request, 0);
+    }
+  }
+}
+
+// Leer y cerrar los contadores, escalando los multiplexados por la fracción
+// del tiempo que estuvieron en la PMU
+static void slot_close(PerfSlot *s, PerfValues *v) {
+  for (int e = 0; e < PERFCTR_EVENTS; e++) {
+    uint64_t data[3];
+    v->valid[e] = 0;
+    v->value[e] = 0;
+    if (s->fd[e] < 0) {
+      continue;
+    }
+    if (read(s->fd[e], data, sizeof(data)) == sizeof(data) && data[2] > 0) {
+      v->value[e] = (data[2] < data[1])
+          ? (uint64_t)((double)data[0] * data[1] / data[2]) : data[0];
+      v->valid[e] = 1;
+    }
+    close(s->fd[e]);
+    s->fd[e] = -1;
+  }
+}
+
+// Un contador en texto: el número o "n/d" (vacío en el CSV)
+static const char *format_value(const PerfValues *v, int e, const char *none,
+                                char *buf, size_t size) {
+  if (!v->valid[e]) {
+    return none;
+  }
+  snprintf(buf, size, "%llu", (unsigned long long)v->value[e]);
+  return buf;
+}
+
+static void format_ipc(const PerfValues *v, const char *none, char *buf,
+                       size_t size) {
+  if (v->valid[EV_CYCLES] && v->valid[EV_INSTRUCTIONS] &&
+      v->value[EV_CYCLES] > 0) {
+    snprintf(buf, size, "%.3f",
+             (double)v->value[EV_INSTRUCTIONS] / v->value[EV_CYCLES]);
+  } else {
+    snprintf(buf, size, "%s", none);
+  }
+}
+
+static void print_console(const char *name, int process, int thread,
+                          const PerfValues *v) {
+  char b[PERFCTR_EVENTS][24], ipc[24];
+  const char *s[PERFCTR_EVENTS];
+  for (int e = 0; e < PERFCTR_EVENTS; e++) {
+    s[e] = format_value(v, e, "n/d", b[e], sizeof(b[e]));
+  }
+  format_ipc(v, "n/d", ipc, sizeof(ipc));
+
+  printf("Contadores [%s] proceso %d hilo %d: ciclos %s, instrucciones %s, "
+         "IPC %s, fallos L1D %s, fallos LLC %s, fallos dTLB %s, "
+         "saltos mal predichos %s\n", name, process, thread,
+         s[EV_CYCLES], s[EV_INSTRUCTIONS], ipc, s[EV_L1D_MISSES],
+         s[EV_LLC_MISSES], s[EV_DTLB_MISSES], s[EV_BRANCH_MISSES]);
+}
+
+// Añadir las filas al CSV. El cerrojo del fichero ordena a los procesos
+// (fork, MPI) que escriben a la vez y decide quién pone la cabecera
+static void append_csv(const char *lines, size_t len) {
+  const char *path = getenv("PERFCTR_CSV");
+  if (path == NULL || path[0] == '\0') {
+    path = PERFCTR_DEFAULT_CSV;
+  }
+
+  int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "PERFCTR: no se puede abrir %s (%s)\n", path,
+            strerror(errno));
+    return;
+  }
+
+  flock(fd, LOCK_EX);
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size == 0) {
+    static const char header[] = "fase,proceso,pid,hilo,ciclos,instrucciones,"
+                                 "ipc,fallos_l1d,fallos_llc,fallos_dtlb,"
+                                 "saltos_mal_predichos\n";
+    if (write(fd, header, sizeof(header) - 1) < 0) {
+      len = 0;
+    }
+  }
+  if (len > 0 && write(fd, lines, len) < 0) {
+    fprintf(stderr, "PERFCTR: error al escribir en %s\n", path);
+  }
+  flock(fd, LOCK_UN);
+  close(fd);
+}
+
+#endif
+
+PerfPhase *perfctr_phase_create(const char *name) {
+#ifdef __linux__
+  if (!perfctr_enabled()) {
+    return NULL;
+  }
+
+  PerfPhase *phase = (PerfPhase *)malloc(sizeof(PerfPhase));
+  if (!phase) {
+    return NULL;
+  }
+  phase->name = name;
+  for (int t = 0; t < PERFCTR_MAX_THREADS; t++) {
+    phase->slot[t].tid = 0;
+    for (int e = 0; e < PERFCTR_EVENTS; e++) {
+      phase->slot[t].fd[e] = -1;
+    }
+  }
+  return phase;
+#else
+  if (perfctr_enabled() && atomic_exchange(&warned, 1) == 0) {
+    fprintf(stderr, "PERFCTR: contadores hardware solo disponibles en Linux\n");
+  }
+  (void)name;
+  return NULL;
+#endif
+}
+
+void perfctr_enter(PerfPhase *phase, int thread) {
+#ifdef __linux__
+  if (!phase || thread < 0 || thread >= PERFCTR_MAX_THREADS) {
+    return;
+  }
+
+  PerfSlot *s = &phase->slot[thread];
+  long self = syscall(SYS_gettid);
+  if (s->tid == 0) {
+    slot_open(s, self);
+  }
+  // Los contadores cuentan al hilo que los abrió: si otro hilo entra con el
+  // mismo índice no se mezcla su trabajo con el de aquel
+  if (s->tid == self) {
+    slot_ioctl(s, PERF_EVENT_IOC_ENABLE);
+  }
+#else
+  (void)phase;
+  (void)thread;
+#endif
+}
+
+void perfctr_leave(PerfPhase *phase, int thread) {
+#ifdef __linux__
+  if (!phase || thread < 0 || thread >= PERFCTR_MAX_THREADS) {
+    return;
+  }
+
+  PerfSlot *s = &phase->slot[thread];
+  if (s->tid > 0) {
+    slot_ioctl(s, PERF_EVENT_IOC_DISABLE);
+  }
+#else
+  (void)phase;
+  (void)thread;
+#endif
+}
+
+void perfctr_phase_finish(PerfPhase *phase, int process) {
+#ifdef __linux__
+  if (!phase) {
+    return;
+  }
+
+  size_t cap = 4096, len = 0;
+  char *csv = (char *)malloc(cap);
+  long pid = (long)getpid();
+
+  // Todas las líneas de la fase juntas aunque otros hilos escriban
+  flockfile(stdout);
+  for (int t = 0; t < PERFCTR_MAX_THREADS; t++) {
+    PerfSlot *s = &phase->slot[t];
+    if (s->tid <= 0) {
+      continue;
+    }
+
+    PerfValues v;
+    slot_ioctl(s, PERF_EVENT_IOC_DISABLE);
+    slot_close(s, &v);
+    print_console(phase->name, process, t, &v);
+
+    char b[PERFCTR_EVENTS][24], ipc[24];
+    const char *f[PERFCTR_EVENTS];
+    for (int e = 0; e < PERFCTR_EVENTS; e++) {
+      f[e] = format_value(&v, e, "", b[e], sizeof(b[e]));
+    }
+    format_ipc(&v, "", ipc, sizeof(ipc));
+
+    if (csv && cap - len < 512) {
+      char *bigger = (char *)realloc(csv, cap * 2);
+      if (!bigger) {
+        free(csv);
+        csv = NULL;
+      } else {
+        csv = bigger;
+        cap *= 2;
+      }
+    }
+    if (csv) {
+      len += snprintf(csv + len, cap - len, "%s,%d,%ld,%d,%s,%s,%s,%s,%s,%s,%s\n",
+                      phase->name, process, pid, t, f[EV_CYCLES],
+                      f[EV_INSTRUCTIONS], ipc, f[EV_L1D_MISSES],
+                      f[EV_LLC_MISSES], f[EV_DTLB_MISSES],
+                      f[EV_BRANCH_MISSES]);
+    }
+  }
+  // Los hijos de fork terminan con _exit, que no vacía stdout
+  fflush(stdout);
+  funlockfile(stdout);
+
+  if (csv && len > 0) {
+    append_csv(csv, len);
+  }
+  free(csv);
+  free(phase);
+#else
+  (void)phase;
+  (void)process;
+#endif
+}
@@ -0,0 +1,40 @@
+#ifndef PERFCTR_H
+#define PERFCTR_H
+
+// Contadores hardware por fase y por hilo con perf_event_open (Linux), para
+// distinguir sin perfiladores externos las ejecuciones limitadas por ancho
+// de banda (IPC bajo con muchos fallos de LLC) de las limitadas por latencia
+// o por saltos. Se activa con PERFCTR=1; cada fase escribe una línea por
+// hilo en la consola y la añade al CSV de PERFCTR_CSV (contadores.csv por
+// defecto). Sin la variable las funciones no hacen nada, y si el núcleo no
+// deja abrir algún contador (perf_event_paranoid, máquinas virtuales sin
+// PMU...) se avisa una vez y ese contador sale como "n/d"
+
+// Ciclos, instrucciones, fallos de L1D, de LLC y de dTLB en lecturas y
+// saltos mal predichos
+#define PERFCTR_EVENTS 6
+
+// Hilos distintos que puede medir una fase
+#define PERFCTR_MAX_THREADS 256
+
+typedef struct PerfPhase PerfPhase;
+
+// Crear una fase con el nombre dado (una cadena que debe seguir viva hasta
+// perfctr_phase_finish). Devuelve NULL si la instrumentación no está
+// activada o falta memoria; el resto de funciones aceptan NULL
+PerfPhase *perfctr_phase_create(const char *name);
+
+// Empezar o reanudar la cuenta del hilo 'thread' (0 <= thread <
+// PERFCTR_MAX_THREADS). Lo llama el propio hilo: la primera vez abre sus
+// contadores, que después se acumulan entre un enter y su leave
+void perfctr_enter(PerfPhase *phase, int thread);
+
+// Detener la cuenta del hilo 'thread' hasta el siguiente perfctr_enter
+void perfctr_leave(PerfPhase *phase, int thread);
+
+// Informar de los contadores de todos los hilos de la fase (con 'process'
+// como índice de proceso o rango MPI), cerrarlos y liberar la fase. Puede
+// llamarse desde cualquier hilo, también cuando los medidos ya terminaron
+void perfctr_phase_finish(PerfPhase *phase, int process);
+
+#endif
@@ -0,0 +1,158 @@
+#!/bin/bash
+# run_gemm_benchmarks.sh
+# Banco de pruebas comun de todas las versiones de multiplicacion de
+# matrices: para cada version, tamaño y numero de hilos (o procesos) hace
+# unas ejecuciones de calentamiento que se descartan y REPS ejecuciones
+# medidas, y guarda la mediana, el percentil 95, la media, la desviacion
+# tipica, los GOP/s (2 n^3 operaciones enteras) y la aceleracion respecto
+# a la version secuencial en CSV y JSON. La aceleracion solo se calcula
+# para las versiones que van detras de "secuencial" en BACKENDS.
+#
+# Se configura con variables de entorno, por ejemplo:
+#   SIZES="512 1024" THREADS="1 2 4" REPS=10 ./run_gemm_benchmarks.sh
+#   BACKENDS="secuencial omp-basic mpi" MPI_MODE=summa THREADS="1 4" ...
+#   VERIFY=1 ./run_gemm_benchmarks.sh   (cada ejecucion con --verify)
+
+# Configuracion
+BINDIR="${BINDIR:-bin}"
+SIZES=(${SIZES:-256 512 1024})
+THREADS=(${THREADS:-1 2 4})
+REPS="${REPS:-5}"
+WARMUP="${WARMUP:-1}"
+BACKENDS=(${BACKENDS:-secuencial pthreads fork omp-basic omp-reduction omp-tasks omp-sections mpi})
+MPIRUN="${MPIRUN:-mpirun}"
+MPIRUN_FLAGS="${MPIRUN_FLAGS:-}"
+MPI_MODE="${MPI_MODE:-filas}"
+VERIFY="${VERIFY:-0}"
+RESULTS_DIR="${RESULTS_DIR:-resultados_gemm}"
+
+CSV="$RESULTS_DIR/resumen.csv"
+JSON="$RESULTS_DIR/resumen.json"
+RAW="$RESULTS_DIR/ejecuciones.csv"
+LOG_FILE="$RESULTS_DIR/log.txt"
+
+# Linea de ordenes de una version para tamaño n con t hilos o procesos
+command_for() {
+    local backend="$1" n="$2" t="$3"
+    case "$backend" in
+        secuencial)    echo "$BINDIR/matrix-mult $n" ;;
+        pthreads)      echo "$BINDIR/matrix-mult-threads $n $t" ;;
+        fork)          echo "$BINDIR/matrix-mult-processes $n $t" ;;
+        omp-basic)     echo "$BINDIR/matrix-mult-omp-basic $n $t" ;;
+        omp-reduction) echo "$BINDIR/matrix-mult-omp-reduction $n $t" ;;
+        omp-tasks)     echo "$BINDIR/matrix-mult-omp-tasks $n $t" ;;
+        omp-sections)  echo "$BINDIR/matrix-mult-omp-sections-generation $n $t" ;;
+        mpi)           echo "$MPIRUN $MPIRUN_FLAGS -np $t $BINDIR/matrix-mult-mpi $n $MPI_MODE" ;;
+        *)             return 1 ;;
+    esac
+}
+
+# Tiempo de la linea "Tiempo de multiplicacion ...: X segundos" (la primera,
+# que en todas las versiones es la de una multiplicacion)
+extract_time() {
+    echo "$1" | grep -m1 "^Tiempo de multiplicacion" | \
+        sed -n 's/.*: \([0-9.]*\) segundos.*/\1/p'
+}
+
+# Estadisticas de una lista de tiempos (uno por linea): mediana, p95 (por
+# rango mas cercano), media y desviacion tipica muestral
+stats() {
+    sort -g | awk '
+        { t[NR] = $1; sum += $1 }
+        END {
+            if (NR == 0) exit 1
+            mean = sum / NR
+            for (i = 1; i <= NR; i++) ss += (t[i] - mean) ^ 2
+            sd = (NR > 1) ? sqrt(ss / (NR - 1)) : 0
+            med = (NR % 2) ? t[(NR + 1) / 2] : (t[NR / 2] + t[NR / 2 + 1]) / 2
+            k = int(0.95 * NR + 0.999999)
+            if (k < 1) k = 1
+            printf "%.6f %.6f %.6f %.6f\n", med, t[k], mean, sd
+        }'
+}
+
+mkdir -p "$RESULTS_DIR"
+echo "Inicio de pruebas: $(date)" > "$LOG_FILE"
+echo "Versiones: ${BACKENDS[*]}" >> "$LOG_FILE"
+echo "Tamaños: ${SIZES[*]}, hilos/procesos: ${THREADS[*]}" >> "$LOG_FILE"
+echo "Calentamiento: $WARMUP, repeticiones: $REPS" >> "$LOG_FILE"
+
+echo "version,n,hilos,ejecucion,tiempo_s" > "$RAW"
+echo "version,n,hilos,repeticiones,mediana_s,p95_s,media_s,desviacion_s,gops,aceleracion" > "$CSV"
+json_sep=""
+echo "[" > "$JSON"
+
+declare -A baseline
+fallos=0
+
+for n in "${SIZES[@]}"; do
+    for backend in "${BACKENDS[@]}"; do
+        # La version secuencial solo se mide con un hilo
+        if [ "$backend" = "secuencial" ]; then
+            hilos=(1)
+        else
+            hilos=("${THREADS[@]}")
+        fi
+
+        for t in "${hilos[@]}"; do
+            if ! cmd=$(command_for "$backend" "$n" "$t"); then
+                echo "Version desconocida: $backend"
+                exit 1
+            fi
+            [ "$VERIFY" = "1" ] && cmd="$cmd --verify"
+            echo -n "$backend n=$n hilos=$t... "
+
+            times=""
+            ok=1
+            for run in $(seq $((1 - WARMUP)) "$REPS"); do
+                output=$($cmd 2>&1)
+                exit_code=$?
+                echo "=== $backend n=$n hilos=$t ejecucion=$run ===" >> "$LOG_FILE"
+                echo "$output" >> "$LOG_FILE"
+
+                time_value=$(extract_time "$output")
+                if [ $exit_code -ne 0 ] || [ -z "$time_value" ]; then
+                    ok=0
+                    break
+                fi
+                # Las ejecuciones de calentamiento (run <= 0) no cuentan
+                if [ "$run" -gt 0 ]; then
+                    times+="$time_value"$'\n'
+                    echo "$backend,$n,$t,$run,$time_value" >> "$RAW"
+                fi
+            done
+
+            if [ $ok -eq 0 ]; then
+                echo "FALLO (ver $LOG_FILE)"
+                fallos=$((fallos + 1))
+                continue
+            fi
+
+            read -r med p95 mean sd < <(printf "%s" "$times" | stats)
+            gops=$(awk -v n="$n" -v t="$med" 'BEGIN { printf "%.3f", (t > 0) ? 2 * n^3 / t / 1e9 : 0 }')
+            if [ "$backend" = "secuencial" ]; then
+                baseline[$n]="$med"
+            fi
+            if [ -n "${baseline[$n]}" ]; then
+                speedup=$(awk -v b="${baseline[$n]}" -v t="$med" 'BEGIN { printf "%.3f", (t > 0) ? b / t : 0 }')
+            else
+                speedup=""
+            fi
+
+            echo "mediana ${med}s, p95 ${p95}s, $gops GOP/s${speedup:+, aceleracion $speedup}"
+            echo "$backend,$n,$t,$REPS,$med,$p95,$mean,$sd,$gops,$speedup" >> "$CSV"
+            printf '%s  {"version": "%s", "n": %d, "hilos": %d, "repeticiones": %d, "mediana_s": %s, "p95_s": %s, "media_s": %s, "desviacion_s": %s, "gops": %s, "aceleracion": %s}' \
+                "$json_sep" "$backend" "$n" "$t" "$REPS" "$med" "$p95" "$mean" "$sd" \
+                "$gops" "${speedup:-null}" >> "$JSON"
+            json_sep=$',\n'
+        done
+    done
+done
+
+printf '\n]\n' >> "$JSON"
+
+echo "Resultados guardados en $CSV, $JSON y $RAW"
+if [ $fallos -gt 0 ]; then
+    echo "$fallos configuraciones fallaron"
+    exit 1
+fi